@@ -0,0 +1,71 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <functional>
+
+#include "logger.hpp"
+#include "expr/expression.hpp"
+#include "expr/register_program.hpp"
+
+// nanoseconds per evaluation of fastest of 5 runs. Same source is built
+// with switch or threaded dispatch and with or without superinstructions,
+// name of build is given as argument
+
+static double ns(const size_t evaluations, const std::function<void()>& f) {
+
+	double best = 0;
+
+	for ( int i = 0; i < 5; i++ ) {
+
+		auto begin = std::chrono::steady_clock::now();
+
+		for ( size_t n = 0; n < evaluations; n++ )
+			f();
+
+		std::chrono::duration<double, std::nano> d = std::chrono::steady_clock::now() - begin;
+		best = i == 0 || d.count() < best ? d.count() : best;
+	}
+
+	return best / evaluations;
+}
+
+int main(int argc, char **argv) {
+
+	logger::loglevel(logger::error);
+
+	const size_t evaluations = 200000;
+	const std::vector<std::string> sources = {
+		"cpu_load * 100",
+		"mem_used / mem_total * 100 + 0.5",
+		"temp > 70 && fan eq 'auto' ? 1 : 0",
+		"cpu_load > 0.8 ? 3 : cpu_load > 0.5 ? 2 : 1",
+		"(temp - 32) * 5 / 9",
+		"date::day() + date::month() * 100"
+	};
+
+	expr::FUNCTIONMAP functions;
+	expr::VARIABLEMAP variables = {
+		{ "cpu_load", 0.5 }, { "temp", 71.0 }, { "fan", std::string("auto") },
+		{ "mem_used", 1234.0 }, { "mem_total", 4096.0 }
+	};
+
+	std::cout << "ns per evaluation, " << ( argc > 1 ? argv[1] : "default build" ) << "\n" << std::endl;
+	std::cout << std::setw(46) << std::left << "expression" << std::right <<
+		std::setw(10) << "stack" << std::setw(10) << "register" << std::endl;
+
+	for ( const std::string& source : sources ) {
+
+		expr::expression e(source);
+		expr::register_program p(e);
+
+		std::cout << std::setw(46) << std::left << source << std::right << std::fixed << std::setprecision(1);
+		std::cout << std::setw(10) << ns(evaluations, [&]() { e.evaluate(&functions, &variables); });
+		std::cout << std::setw(10) << ns(evaluations, [&]() { p.run(&functions, &variables); });
+		std::cout << std::endl;
+	}
+
+	std::cout << std::endl;
+	return 0;
+}
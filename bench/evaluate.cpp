@@ -0,0 +1,72 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <functional>
+
+#include "logger.hpp"
+#include "expr/expression.hpp"
+#include "expr/bound_expression.hpp"
+#include "expr/variable_store.hpp"
+
+// nanoseconds per evaluation of fastest of 5 runs. Evaluations do not
+// allocate, that is checked by test_alloc
+static double ns(const size_t evaluations, const std::function<void()>& f) {
+
+	double best = 0;
+
+	for ( int i = 0; i < 5; i++ ) {
+
+		auto begin = std::chrono::steady_clock::now();
+
+		for ( size_t n = 0; n < evaluations; n++ )
+			f();
+
+		std::chrono::duration<double, std::nano> d = std::chrono::steady_clock::now() - begin;
+		best = i == 0 || d.count() < best ? d.count() : best;
+	}
+
+	return best / evaluations;
+}
+
+int main() {
+
+	logger::loglevel(logger::error);
+
+	const size_t evaluations = 200000;
+	const std::vector<std::string> sources = {
+		"cpu_load * 100",
+		"mem_used / mem_total * 100 + 0.5",
+		"temp > 70 && fan eq 'auto' ? 1 : 0",
+		"'CPU ' . round(cpu_load * 100) . '%'",
+		"(temp - 32) * 5 / 9"
+	};
+
+	expr::FUNCTIONMAP functions;
+	expr::VARIABLEMAP variables = {
+		{ "cpu_load", 0.5 }, { "temp", 71.0 }, { "fan", std::string("auto") },
+		{ "mem_used", 1234.0 }, { "mem_total", 4096.0 }
+	};
+	expr::variable_store store(variables);
+	expr::SCHEMA schema = { "cpu_load", "temp", "fan", "mem_used", "mem_total" };
+	std::vector<expr::VARIABLE> slots = { 0.5, 71.0, std::string("auto"), 1234.0, 4096.0 };
+
+	std::cout << "ns per evaluation with variables from map, store and slots of schema\n" << std::endl;
+	std::cout << std::setw(40) << std::left << "expression" << std::right <<
+		std::setw(10) << "map" << std::setw(10) << "store" << std::setw(10) << "slots" << std::endl;
+
+	for ( const std::string& source : sources ) {
+
+		expr::expression e(source);
+		expr::bound_expression b(e, schema, &functions);
+
+		std::cout << std::setw(40) << std::left << source << std::right << std::fixed << std::setprecision(1);
+		std::cout << std::setw(10) << ns(evaluations, [&]() { e.evaluate(&functions, &variables); });
+		std::cout << std::setw(10) << ns(evaluations, [&]() { e.evaluate(&functions, store); });
+		std::cout << std::setw(10) << ns(evaluations, [&]() { b.evaluate(slots); });
+		std::cout << std::endl;
+	}
+
+	return 0;
+}
@@ -0,0 +1,110 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <functional>
+
+#include "logger.hpp"
+#include "expr/ops.hpp"
+#include "expr/kernels.hpp"
+
+// rows per second of fastest of 5 runs
+static double rate(const size_t rows, const std::function<void()>& f) {
+
+	double best = 0;
+
+	for ( int i = 0; i < 5; i++ ) {
+
+		auto begin = std::chrono::steady_clock::now();
+		f();
+		std::chrono::duration<double> d = std::chrono::steady_clock::now() - begin;
+		best = i == 0 || d.count() < best ? d.count() : best;
+	}
+
+	return rows / best;
+}
+
+int main() {
+
+	logger::loglevel(logger::error);
+
+	const size_t rows = 1024;
+	const size_t passes = 2000;
+	std::vector<double> a(rows), b(rows), r(rows);
+	std::mt19937 rng(1);
+
+	for ( size_t i = 0; i < rows; i++ ) {
+		a[i] = ( rng() % 10000 ) / 100.0 + 1;
+		b[i] = ( rng() % 10000 ) / 100.0 + 1;
+	}
+
+	const std::vector<expr::OP> ops = {
+		expr::OP_ADD, expr::OP_SUB, expr::OP_MUL, expr::OP_DIV, expr::OP_MOD, expr::OP_POW,
+		expr::OP_OR, expr::OP_AND, expr::OP_NEQ, expr::OP_NNE, expr::OP_NLT, expr::OP_NLE,
+		expr::OP_NGT, expr::OP_NGE
+	};
+
+	const std::vector<expr::kernels::ISA> isas = {
+		expr::kernels::ISA_GENERIC, expr::kernels::ISA_SSE2,
+		expr::kernels::ISA_AVX2, expr::kernels::ISA_AVX512
+	};
+
+	std::cout << "rows/s of operators on chunks of " << rows << " rows, selected isa is " <<
+		describe(expr::kernels::isa()) << "\n" << std::endl;
+
+	std::cout << std::setw(10) << "operator" << std::setw(12) << "scalar";
+	for ( expr::kernels::ISA isa : isas )
+		std::cout << std::setw(12) << describe(isa);
+	std::cout << std::endl;
+
+	expr::kernels::ISA selected = expr::kernels::isa();
+
+	for ( expr::OP op : ops ) {
+
+		std::cout << std::setw(10) << describe(op) << std::setprecision(3);
+
+		// expr::ops applied row by row
+		std::cout << std::setw(12) << rate(rows * passes, [&]() {
+			for ( size_t p = 0; p < passes; p++ )
+				for ( size_t i = 0; i < rows; i++ ) {
+					double n;
+					switch ( op ) {
+						case expr::OP_ADD: n = expr::ops::ADD(a[i], b[i]); break;
+						case expr::OP_SUB: n = expr::ops::SUB(a[i], b[i]); break;
+						case expr::OP_MUL: n = expr::ops::MUL(a[i], b[i]); break;
+						case expr::OP_DIV: n = expr::ops::DIV(a[i], b[i]); break;
+						case expr::OP_MOD: n = expr::ops::MOD(a[i], b[i]); break;
+						case expr::OP_POW: n = expr::ops::POW(a[i], b[i]); break;
+						case expr::OP_OR: n = expr::ops::OR(a[i], b[i]); break;
+						case expr::OP_AND: n = expr::ops::AND(a[i], b[i]); break;
+						case expr::OP_NEQ: n = expr::ops::NEQ(a[i], b[i]); break;
+						case expr::OP_NNE: n = expr::ops::NNE(a[i], b[i]); break;
+						case expr::OP_NLT: n = expr::ops::NLT(a[i], b[i]); break;
+						case expr::OP_NLE: n = expr::ops::NLE(a[i], b[i]); break;
+						case expr::OP_NGT: n = expr::ops::NGT(a[i], b[i]); break;
+						default: n = expr::ops::NGE(a[i], b[i]); break;
+					}
+					r[i] = n;
+				}
+		});
+
+		for ( expr::kernels::ISA isa : isas ) {
+
+			if ( !expr::kernels::select(isa)) {
+				std::cout << std::setw(12) << "-";
+				continue;
+			}
+
+			std::cout << std::setw(12) << rate(rows * passes, [&]() {
+				for ( size_t p = 0; p < passes; p++ )
+					expr::kernels::binary(op, a, b, r);
+			});
+		}
+
+		std::cout << std::endl;
+	}
+
+	expr::kernels::select(selected);
+	return 0;
+}
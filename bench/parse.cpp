@@ -0,0 +1,62 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <chrono>
+#include <functional>
+
+#include "logger.hpp"
+#include "expr/lexer.hpp"
+#include "expr/expression.hpp"
+
+// microseconds per pass of fastest of 5 runs
+static double us(const size_t passes, const std::function<void()>& f) {
+
+	double best = 0;
+
+	for ( int i = 0; i < 5; i++ ) {
+
+		auto begin = std::chrono::steady_clock::now();
+
+		for ( size_t n = 0; n < passes; n++ )
+			f();
+
+		std::chrono::duration<double, std::micro> d = std::chrono::steady_clock::now() - begin;
+		best = i == 0 || d.count() < best ? d.count() : best;
+	}
+
+	return best / passes;
+}
+
+int main() {
+
+	logger::loglevel(logger::error);
+
+	const std::string unit = "xxx + 1.5 * hello(2, 'abc', (y - 3)) . 'some text' - (3 + yy) ";
+	size_t lexemes = 0;
+
+	std::cout << "us per expression, expression is parsed, optimized and compiled\n" << std::endl;
+	std::cout << std::setw(8) << "size" << std::setw(12) << "lexer" << std::setw(12) << "expression" << std::endl;
+
+	for ( size_t size : { 1024, 10240, 102400 }) {
+
+		std::string source;
+		size_t passes = 2048000 / size;
+
+		while ( source.size() < size )
+			source += source.empty() ? unit : "+ " + unit;
+
+		std::cout << std::setw(5) << size / 1024 << " KB" << std::fixed << std::setprecision(1);
+
+		std::cout << std::setw(12) << us(passes, [&]() {
+			expr::lexer lex(source);
+			while ( lex.next().type != expr::L_END )
+				lexemes++;
+		});
+
+		std::cout << std::setw(12) << us(passes, [&]() {
+			expr::expression e(source);
+		}) << std::endl;
+	}
+
+	return lexemes == 0;
+}
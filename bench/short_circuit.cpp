@@ -0,0 +1,74 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <chrono>
+
+#include "logger.hpp"
+#include "expr/expression.hpp"
+
+// user function with a small busy loop, counts its calls
+static size_t calls = 0;
+
+static expr::VARIABLE sensor(const expr::FUNCTION_ARGS& args) {
+
+	volatile double x = 0;
+
+	calls++;
+
+	for ( int i = 0; i < 200; i++ )
+		x = x + i;
+
+	return args.empty() ? 0 : args[0].to_double() * 10;
+}
+
+int main() {
+
+	logger::loglevel(logger::error);
+
+	const size_t evaluations = 100000;
+
+	// && and || skip right side when left side decides result, & and |
+	// evaluate both sides and show cost without short circuit
+	const std::vector<std::string> sources = {
+		"mode ? sensor(1) : sensor(2)",
+		"sensor(1) > 50 ? 'hot' : sensor(2) > 50 ? 'warm' : 'cold'",
+		"mode == 0 && sensor(3) > 10",
+		"mode == 0 & sensor(3) > 10",
+		"mode == 1 || sensor(4) > 10",
+		"mode == 1 | sensor(4) > 10",
+		"sensor(9) > 50 && sensor(2) > 10 || sensor(3) > 0",
+		"sensor(9) > 50 & sensor(2) > 10 | sensor(3) > 0"
+	};
+
+	expr::FUNCTIONMAP functions = { { "sensor", sensor } };
+	expr::VARIABLEMAP variables = { { "mode", 1.0 } };
+
+	std::cout << "calls of sensor and ns per evaluation, fastest of 5 runs\n" << std::endl;
+	std::cout << std::setw(58) << std::left << "expression" << std::right <<
+		std::setw(8) << "calls" << std::setw(10) << "ns" << std::endl;
+
+	for ( const std::string& source : sources ) {
+
+		expr::expression e(source);
+		double best = 0;
+
+		for ( int i = 0; i < 5; i++ ) {
+
+			calls = 0;
+			auto begin = std::chrono::steady_clock::now();
+
+			for ( size_t n = 0; n < evaluations; n++ )
+				e.evaluate(&functions, &variables);
+
+			std::chrono::duration<double, std::nano> d = std::chrono::steady_clock::now() - begin;
+			best = i == 0 || d.count() < best ? d.count() : best;
+		}
+
+		std::cout << std::setw(58) << std::left << source << std::right << std::fixed <<
+			std::setprecision(2) << std::setw(8) << (double)calls / evaluations <<
+			std::setprecision(1) << std::setw(10) << best / evaluations << std::endl;
+	}
+
+	return 0;
+}
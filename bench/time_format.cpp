@@ -0,0 +1,89 @@
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <ctime>
+#include <functional>
+
+#include "logger.hpp"
+#include "expr/time_format.hpp"
+
+// nanoseconds per call of fastest of 5 runs
+static double ns(const size_t calls, const std::function<void()>& f) {
+
+	double best = 0;
+
+	for ( int i = 0; i < 5; i++ ) {
+
+		auto begin = std::chrono::steady_clock::now();
+		f();
+		std::chrono::duration<double, std::nano> d = std::chrono::steady_clock::now() - begin;
+		best = i == 0 || d.count() < best ? d.count() : best;
+	}
+
+	return best / calls;
+}
+
+int main() {
+
+	logger::loglevel(logger::error);
+
+	const size_t calls = 200000;
+	const std::vector<std::string> formats = {
+		"%Y-%m-%d %H:%M:%S", "%a %d.%m. %H:%M", "%H:%M", "%b %e %Y", "%c"
+	};
+
+	std::time_t t = 1792227502;
+	std::tm tm;
+	std::string out;
+	size_t sink = 0;
+
+	localtime_r(&t, &tm);
+
+	std::cout << "ns per call, put_time is formatting before compiled formats\n" << std::endl;
+	std::cout << std::setw(22) << "format" << std::setw(12) << "put_time" << std::setw(12) << "strftime" <<
+		std::setw(12) << "compiled" << std::setw(12) << "cached" << std::endl;
+
+	for ( const std::string& format : formats ) {
+
+		expr::time_format compiled(format);
+
+		std::cout << std::setw(22) << format << std::fixed << std::setprecision(1);
+
+		// stringstream and std::put_time on every call
+		std::cout << std::setw(12) << ns(calls, [&]() {
+			for ( size_t i = 0; i < calls; i++ ) {
+				std::stringstream ss;
+				ss << std::put_time(&tm, format.c_str());
+				sink += ss.str().size();
+			}
+		});
+
+		std::cout << std::setw(12) << ns(calls, [&]() {
+			for ( size_t i = 0; i < calls; i++ ) {
+				char buf[256];
+				sink += std::strftime(buf, sizeof(buf), format.c_str(), &tm);
+			}
+		});
+
+		std::cout << std::setw(12) << ns(calls, [&]() {
+			for ( size_t i = 0; i < calls; i++ ) {
+				compiled.format(tm, out);
+				sink += out.size();
+			}
+		});
+
+		std::cout << std::setw(12) << ns(calls, [&]() {
+			for ( size_t i = 0; i < calls; i++ ) {
+				expr::time_format::cached(format).format(tm, out);
+				sink += out.size();
+			}
+		});
+
+		std::cout << std::endl;
+	}
+
+	return sink == 0;
+}
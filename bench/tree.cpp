@@ -0,0 +1,71 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <new>
+
+#include "logger.hpp"
+#include "expr/expression.hpp"
+#include "expr/tree.hpp"
+
+// bytes of expression tree, as tree of TOKENs and as flat tree of
+// nodes. Bytes of TOKENs are bytes requested from operator new by copy
+// of root token, together with root token itself
+
+static size_t requested = 0;
+
+void* operator new(size_t size) {
+
+	requested += size;
+
+	if ( void *p = std::malloc(size == 0 ? 1 : size); p != nullptr )
+		return p;
+
+	throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept {
+	std::free(p);
+}
+
+void operator delete(void *p, size_t) noexcept {
+	std::free(p);
+}
+
+int main() {
+
+	logger::loglevel(logger::error);
+
+	const std::vector<std::string> sources = {
+		"42",
+		"cpu_load * 100",
+		"mem_used / mem_total * 100 + 0.5",
+		"temp > 70 && fan eq 'auto' ? 1 : 0",
+		"'CPU ' . round(cpu_load * 100) . '%'",
+		"to_string(date::day()) . '.' . to_string(date::month()) . '.' . to_string(date::year()) . ' ' . "
+			"to_string(time::hour()) . ':' . to_string(time::min())"
+	};
+
+	std::cout << "sizeof TOKEN " << sizeof(expr::TOKEN) << ", NODE " << sizeof(expr::NODE) <<
+		", tree " << sizeof(expr::tree) << ", expression " << sizeof(expr::expression) << "\n" << std::endl;
+	std::cout << std::setw(40) << std::left << "expression" << std::right <<
+		std::setw(8) << "nodes" << std::setw(10) << "tokens" << std::setw(10) << "flat" << std::endl;
+
+	for ( const std::string& source : sources ) {
+
+		expr::expression e(source);
+		expr::TOKEN root = e.root();
+		size_t before = requested;
+		expr::TOKEN *copy = new expr::TOKEN(root);
+		size_t tokens = requested - before;
+
+		delete copy;
+
+		std::cout << std::setw(40) << std::left << ( source.size() > 38 ? source.substr(0, 35) + "..." : source ) <<
+			std::right << std::setw(8) << e.syntax_tree().nodes().size() << std::setw(10) << tokens <<
+			std::setw(10) << sizeof(expr::tree) + e.syntax_tree().size() << std::endl;
+	}
+
+	return 0;
+}
@@ -0,0 +1,155 @@
+#pragma once
+
+#include <span>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "expr/variable.hpp"
+#include "expr/function.hpp"
+#include "expr/context.hpp"
+#include "expr/program.hpp"
+#include "expr/value.hpp"
+#include "expr/expression.hpp"
+
+namespace expr {
+
+	// rows of chunk, dense selection is rows 0 ... count - 1
+	struct SELECTION {
+
+		bool dense = true;
+		size_t count = 0;
+		std::vector<uint16_t> rows;
+	};
+
+	// expression evaluated over columns of rows, vector at a time.
+	// Columns are bound to variable names, variables that are not bound
+	// are evaluated as unset. Rows are evaluated in chunks of CHUNK rows
+	// and operators on numbers are applied to whole chunk at once.
+	// Branches of conditionals, && and || are evaluated only for rows
+	// that select them, so functions are called like they would be
+	// called when rows are evaluated one by one. Assignment is evaluated,
+	// but variable is not set
+	class batch {
+
+	private:
+		enum COLUMN_TYPE { C_NUMBERS, C_STRINGS, C_SCALAR };
+
+		struct COLUMN {
+
+			std::string name;
+			COLUMN_TYPE type = C_SCALAR;
+			std::span<const double> numbers;
+			std::span<const std::string> strings;
+			VARIABLE scalar;
+		};
+
+		// column of stack, rows are in numbers while all of them are numbers
+		struct SLOT {
+
+			bool numeric = true;
+			std::vector<double> numbers;
+			std::vector<value> values;
+
+			value get(const size_t row) const {
+				return this -> numeric ? value::NUMBER(this -> numbers[row]) : this -> values[row];
+			}
+
+			void put(const size_t row, const value v, const size_t count) {
+
+				if ( this -> numeric && v.is_number()) {
+					this -> numbers[row] = v.number();
+					return;
+				} else if ( this -> numeric ) {
+					for ( size_t i = 0; i < count; i++ )
+						this -> values[i] = value::NUMBER(this -> numbers[i]);
+					this -> numeric = false;
+				}
+
+				this -> values[row] = v;
+			}
+		};
+
+		// branch of conditional, && or ||
+		struct FRAME {
+
+			size_t end; // instruction where branches join
+			size_t saved; // selection before branch
+			size_t other; // selection of else branch
+			size_t mark; // selections allocated before branch
+			size_t sp; // stack pointer of else branch
+		};
+
+		expr::expression _expression;
+		expr::program _program;
+		FUNCTIONMAP *_functions = nullptr;
+		std::vector<COLUMN> _columns;
+		std::vector<std::string> _unknown;
+		bool _bound = false;
+
+		std::vector<SLOT> _stack;
+		std::vector<FRAME> _frames;
+		std::vector<SELECTION> _selections;
+		std::vector<value> _argv;
+		SELECTION _within, _matched, _unmatched;
+
+		const int column(const std::string& name) const;
+		COLUMN& add(const std::string& name);
+		void bind();
+		const bool check(const size_t rows);
+		void execute(context& ctx, const size_t base, const size_t count, const SELECTION *within = nullptr);
+		void match(context& ctx, const size_t base, const size_t count);
+
+	public:
+
+		static constexpr size_t CHUNK = 1024;
+
+		// binds column to variable name, column replaces earlier column of
+		// same name. Columns are not copied, they must stay valid until
+		// evaluated. Scalar is same for all rows
+		void bind(const std::string& name, std::span<const double> column);
+		void bind(const std::string& name, std::span<const std::string> column);
+		void bind(const std::string& name, const VARIABLE& scalar);
+		void clear();
+
+		// links function calls again, call when host adds, removes
+		// or replaces functions
+		void link(FUNCTIONMAP *functions);
+
+		const std::vector<std::string>& unknown() const;
+		const size_t columns() const;
+
+		// evaluates rows 0 ... results.size() - 1 to results, false when
+		// a column has fewer rows. Results that are not numbers are
+		// converted like VARIABLE::to_double() converts them
+		const bool evaluate(std::span<double> results);
+		const bool evaluate(context& ctx, std::span<double> results);
+
+		// string results reuse storage of results
+		const bool evaluate(std::span<VARIABLE> results);
+		const bool evaluate(context& ctx, std::span<VARIABLE> results);
+
+		// expression as predicate of rows 0 ... rows - 1, row matches when
+		// its result is true like condition of ?: tests it. Results are
+		// not stored, rows of chunk that do not match are dropped after
+		// each && and ||. Bit r % 64 of mask[r / 64] is set for matching
+		// row r, bits after last row are cleared. False when a column or
+		// mask has fewer rows
+		const bool filter(const size_t rows, std::span<uint64_t> mask);
+		const bool filter(context& ctx, const size_t rows, std::span<uint64_t> mask);
+
+		// indices of matching rows in ascending order to selected
+		const bool filter(const size_t rows, std::vector<uint32_t>& selected);
+		const bool filter(context& ctx, const size_t rows, std::vector<uint32_t>& selected);
+
+		// only rows, ascending indices f.e. from earlier filter, are
+		// evaluated; matching ones of them are stored to selected, which
+		// must not be rows
+		const bool filter(std::span<const uint32_t> rows, std::vector<uint32_t>& selected);
+		const bool filter(context& ctx, std::span<const uint32_t> rows, std::vector<uint32_t>& selected);
+
+		batch();
+		batch(const expression& e, FUNCTIONMAP *functions = nullptr);
+
+	};
+
+} // end of namespace expr
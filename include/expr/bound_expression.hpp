@@ -0,0 +1,51 @@
+#pragma once
+
+#include <span>
+#include <string>
+#include <vector>
+#include "expr/variable.hpp"
+#include "expr/function.hpp"
+#include "expr/token.hpp"
+#include "expr/context.hpp"
+#include "expr/program.hpp"
+#include "expr/expression.hpp"
+
+namespace expr {
+
+	// expression bound to a schema of variables. Names are resolved
+	// to slots once, when bound, and function calls are linked to
+	// functions, so expression is evaluated against a slot array
+	// without looking up anything by name
+	class bound_expression {
+
+	private:
+		expr::expression _expression;
+		expr::program _program;
+		SCHEMA _schema;
+		std::vector<std::string> _unbound;
+		std::vector<std::string> _unknown;
+		FUNCTIONMAP *_functions = nullptr;
+
+		void bind();
+
+	public:
+
+		const SCHEMA& schema() const;
+		const std::vector<std::string>& unbound() const;
+		const std::vector<std::string>& unknown() const;
+		const int slot(const std::string& name) const;
+		const expr::program& compiled() const;
+
+		// links function calls again, call when host adds, removes
+		// or replaces functions
+		void link(FUNCTIONMAP *functions);
+
+		TOKEN evaluate(std::span<VARIABLE> slots) const;
+		TOKEN evaluate(context& ctx, std::span<VARIABLE> slots) const;
+
+		bound_expression();
+		bound_expression(const expression& e, const SCHEMA& schema, FUNCTIONMAP *functions = nullptr);
+
+	};
+
+} // end of namespace expr
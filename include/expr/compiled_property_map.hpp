@@ -0,0 +1,145 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <variant>
+#include <cstdint>
+#include <unordered_map>
+#include "expr/function.hpp"
+#include "expr/variable.hpp"
+#include "expr/result.hpp"
+#include "expr/context.hpp"
+#include "expr/program.hpp"
+#include "expr/property.hpp"
+#include "expr/expression.hpp"
+
+namespace expr {
+
+	// properties compiled once and kept with their source. When
+	// properties are loaded again, only entries with changed source are
+	// compiled; those get generation of that load. Keys are case
+	// insensitive like keys of PROPERTYMAP and each key has a dense id
+	// that stays same until key is removed.
+	// evaluate_all() evaluates every property to a table indexed by id.
+	// For it, programs of properties are bound to one schema of all
+	// variables they read, and variables are copied to slots of schema
+	// once for each pass.
+	// recompute() evaluates only properties that are affected by changed
+	// variables. Variables that property reads and variable that it sets
+	// form a dependency graph of properties; properties are evaluated in
+	// its topological order so that property reading variable is
+	// evaluated after property that sets it. Properties that call
+	// functions that are not pure are evaluated on every pass
+	class compiled_property_map {
+
+	private:
+		struct ENTRY {
+
+			std::string key; // empty when id is free
+			std::string source;
+			expr::expression compiled;
+			expr::program bound;
+			std::string pretty;
+			uint64_t generation = 0;
+
+			std::vector<size_t> reads; // slots of variables that are read
+			size_t writes = SIZE_MAX; // slot of variable that is set
+			bool impure = false; // calls functions that are not pure
+			bool pending = true; // evaluated on next recompute()
+		};
+
+		std::vector<ENTRY> _entries;
+		std::unordered_map<std::string, size_t> _ids;
+		std::vector<size_t> _free;
+
+		SCHEMA _schema;
+		std::unordered_map<SYMBOL, size_t> _slots_of;
+		std::vector<VARIABLE> _fallbacks;
+		std::vector<VARIABLE> _slots;
+
+		std::vector<size_t> _order; // live entries in topological order
+		std::vector<std::vector<size_t>> _readers; // entries reading slot
+		std::vector<size_t> _dirty; // slots marked dirty since last recompute
+		std::vector<bool> _marked;
+		std::vector<size_t> _changed;
+		size_t _loaded = 0; // count of slots loaded from variables
+		bool _sorted = false;
+		VARIABLE _previous;
+		VARIABLE _result;
+
+		expr::FUNCTIONMAP *_funcs;
+		expr::VARIABLEMAP *_vars;
+		uint64_t _generation = 0;
+		size_t _compiled = 0;
+
+		const ENTRY* entry(const std::string& key) const;
+		const size_t slot(const SYMBOL id);
+		void fetch(const size_t slot);
+		const bool update(const std::string& key, const std::string& source);
+		void bind(ENTRY& e);
+		void remove(const size_t id);
+		void sort();
+		void changed(const size_t slot);
+
+	public:
+
+		static constexpr size_t NONE = SIZE_MAX;
+
+		// replaces properties with m, returns count of compiled entries
+		const size_t load(const expr::PROPERTYMAP& m);
+
+		// sets one property, it is compiled if source changed
+		void set(const std::string& key, const std::string& source);
+		const bool erase(const std::string& key);
+		void clear();
+
+		// links function calls again, call when functions are added, removed or replaced
+		void link(expr::FUNCTIONMAP *functions);
+
+		const bool contains(const std::string& key) const;
+		const size_t size() const;
+
+		const size_t id(const std::string& key) const; // NONE when key is not set
+		const std::string key(const size_t id) const;
+		const size_t ids() const; // size of result table
+
+		const uint64_t generation() const;
+		const uint64_t generation(const std::string& key) const; // 0 when key is not set
+		const size_t compiled() const; // count of compiled entries since construction
+
+		expr::RESULT get(const std::string& key, const std::variant<double, std::string, std::nullptr_t>& def = nullptr) const;
+		expr::RESULT operator [](const std::string& key) const;
+
+		// evaluates all properties to results[id], like they were read with
+		// operator []. Storage of results is reused, so results should be
+		// kept between passes. Evaluations share time of pass. Properties
+		// are evaluated in same order as in recompute() and variables set
+		// by properties are written to variables of map
+		void evaluate_all(std::vector<expr::RESULT>& results);
+		void evaluate_all(expr::context& ctx, std::vector<expr::RESULT>& results);
+
+		// marks variable changed by host, properties reading it are
+		// evaluated on next recompute(). invalidate() marks all
+		void mark_dirty(const std::string& name);
+		void invalidate();
+
+		// evaluates properties affected by dirty variables, changed or
+		// new properties and properties that are not pure, to results[id].
+		// Results must be kept between passes. Returns ids of properties
+		// whose result changed, valid until next call. Variables set by
+		// properties are written to variables of map. Property that is in a
+		// cycle of dependencies is evaluated again on next pass, when a
+		// variable it reads is set after it was evaluated
+		const std::vector<size_t>& recompute(std::vector<expr::RESULT>& results);
+		const std::vector<size_t>& recompute(expr::context& ctx, std::vector<expr::RESULT>& results);
+
+		const std::string raw(const std::string& key) const;
+		const std::string pretty(const std::string& key) const;
+		const expr::expression* expression(const std::string& key) const; // nullptr when key is not set
+
+		compiled_property_map(expr::FUNCTIONMAP *f = nullptr, expr::VARIABLEMAP *v = nullptr);
+		compiled_property_map(const expr::PROPERTYMAP& m, expr::FUNCTIONMAP *f = nullptr, expr::VARIABLEMAP *v = nullptr);
+
+	};
+
+} // end of namespace expr
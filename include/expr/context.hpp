@@ -0,0 +1,116 @@
+#pragma once
+
+#include <ctime>
+#include <array>
+#include <deque>
+#include <chrono>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <memory_resource>
+#include "expr/variable.hpp"
+#include "expr/function.hpp"
+#include "expr/value.hpp"
+#include "expr/memo.hpp"
+
+namespace expr {
+
+	// scratch memory of evaluations. Value stacks and strings are
+	// allocated from a monotonic arena that is released, not freed, when
+	// an outermost evaluation begins, so after first evaluations nothing
+	// is allocated. Strings of values are indexes to string table of context.
+	// Functions may evaluate other expressions with same context while it
+	// is in use. Context is not shared between threads, context::local()
+	// is the context of calling thread. Context also keeps time of
+	// evaluation for time and date functions, and memo of function calls
+	class context {
+
+	public:
+
+		// result of expression's check that maps do not shadow names that
+		// its folded program assumed, valid while maps and their sizes stay same
+		struct ASSUMPTION {
+
+			uint64_t expression = 0; // id of expression, 0 when free
+			const void *functions = nullptr;
+			const void *variables = nullptr;
+			size_t functions_size = 0;
+			size_t variables_size = 0;
+			bool hold = true;
+		};
+
+	private:
+		alignas(std::max_align_t) std::array<std::byte, 4096> _buffer;
+		std::pmr::unsynchronized_pool_resource _pool;
+		std::pmr::monotonic_buffer_resource _arena;
+		std::deque<FUNCTION_ARGS> _args; // one for each depth of evaluation
+		std::vector<std::string_view> _strings;
+		size_t _depth = 0;
+
+		std::chrono::system_clock::time_point _now;
+		bool _now_set = false;
+		bool _clock_held = false;
+		uint64_t _tick = 0;
+		std::tm _tm;
+		uint64_t _tm_tick = 0; // tick of _tm, 0 when not converted
+		context *_previous = nullptr;
+		expr::memo _memo;
+		std::array<ASSUMPTION, 16> _assumptions;
+
+	public:
+
+		// value stack of size values, released with leave()
+		value* enter(const size_t size);
+		void leave();
+
+		// string that stays unchanged until evaluation ends, f.e. constant
+		// of program. Index 0 is always an empty string
+		const uint32_t view(std::string_view s);
+
+		// copy of s1 and s2 joined
+		const uint32_t copy(std::string_view s1, std::string_view s2 = {});
+
+		std::string_view string(const uint32_t index) const {
+			return this -> _strings[index];
+		}
+
+		// arguments copied for functions that take FUNCTION_ARGS
+		FUNCTION_ARGS& args();
+
+		const size_t depth() const;
+		std::pmr::memory_resource* arena();
+
+		// time of evaluation, clock is read once for each outermost evaluation.
+		// While clock is held, all evaluations share time of hold_clock()
+		const std::chrono::system_clock::time_point now();
+		void hold_clock();
+		void release_clock();
+		const bool clock_held() const;
+
+		// now() as local time, converted once for each time of evaluation
+		const std::tm& local_time();
+
+		// count of clock reads, stays same while time of evaluation is same.
+		// Clock is read if it was not read for current evaluation
+		const uint64_t tick();
+
+		// results of pure and per tick function calls
+		expr::memo& memo();
+
+		// entry of expression in direct mapped table of assumption checks,
+		// entry may belong to another expression
+		ASSUMPTION& assumption(const uint64_t expression);
+
+		static context& local();
+
+		// context of evaluation running on calling thread, nullptr when none is
+		static context* current();
+
+		context();
+		context(const context&) = delete;
+		context& operator =(const context&) = delete;
+
+	};
+
+} // end of namespace expr
@@ -10,21 +10,49 @@
 #include "expr/property.hpp"
 #include "expr/result.hpp"
 #include "expr/token.hpp"
+#include "expr/tree.hpp"
+#include "expr/context.hpp"
+#include "expr/program.hpp"
+#include "expr/symbols.hpp"
 
 namespace expr {
 
+	class lexer;
+
 	class expression {
 
+	friend class bound_expression;
+	friend class compiled_property_map;
+	friend class batch;
+
 	private:
 
 		std::string _raw;
-		std::vector<TOKEN> _tokens;
+		expr::tree _tree;
+		expr::program _program;
+
+		// constant folding assumes that named constants and pure
+		// builtins it used are not shadowed by variables or user
+		// functions, if they are, unfolded program is evaluated.
+		// Maps are checked when they or their sizes change, result
+		// is kept in context by id of expression
+		expr::program _unfolded;
+		std::vector<std::string> _assumed_variables;
+		std::vector<SYMBOL> _assumed_symbols;
+		std::vector<std::string> _assumed_functions;
+		uint64_t _id = 0; // 0 when nothing was assumed
+		bool _constant = false;
+		VARIABLE _value;
 
 	public:
 
 		const std::string raw() const;
-		const std::vector<TOKEN>& tokens();
-		const std::vector<TOKEN> tokens() const;
+		const TOKEN root() const;
+		const expr::tree& syntax_tree() const;
+		const expr::program& compiled() const;
+
+		const bool is_constant(FUNCTIONMAP *functions = nullptr, VARIABLEMAP *variables = nullptr) const;
+		const VARIABLE constant_value() const;
 
 		operator std::string() const;
 		const std::string to_string() const;
@@ -34,33 +62,30 @@ namespace expr {
 		~expression();
 
 		void parse(const std::string& s);
-		TOKEN evaluate(FUNCTIONMAP *functions = nullptr, VARIABLEMAP *variables = nullptr);
+		TOKEN evaluate(FUNCTIONMAP *functions = nullptr, VARIABLEMAP *variables = nullptr) const;
+		TOKEN evaluate(context& ctx, FUNCTIONMAP *functions = nullptr, VARIABLEMAP *variables = nullptr) const;
+
+		// variables are read from store, variable that is set is written to it
+		TOKEN evaluate(FUNCTIONMAP *functions, variable_store& variables) const;
+		TOKEN evaluate(context& ctx, FUNCTIONMAP *functions, variable_store& variables) const;
+
+		// replaces expression with s, parsed expressions are taken from parse_cache::global()
 		TOKEN evaluate(const std::string& s, FUNCTIONMAP *functions, VARIABLEMAP *variables);
 
 		friend std::ostream& operator <<(std::ostream& os, expression const& e);
 
 	private:
 		// internal parser functions
-		static std::vector<TOKEN> parse_expr(const std::string& expr, bool f_args);
-		static bool validate_set_op(std::vector<TOKEN>& tokens, const std::string& expr, bool is_root);
-		std::vector<TOKEN> parse_expr(const std::string& s);
-
-		// internal evaluation functions
-		static std::vector<std::vector<TOKEN>> get_arg_tokens(const std::vector<TOKEN>& tokens);
-		static const VARIABLE get_variable_value(const std::string& name, VARIABLEMAP *variables);
-		static TOKEN tokenize_variable_value(const std::string& name, VARIABLEMAP *variables);
-		static std::vector<TOKEN> eval_functions(
-			std::vector<TOKEN>& tokens, FUNCTIONMAP *functions, VARIABLEMAP *variables);
-		static std::vector<TOKEN> eval_variables(
-			std::vector<TOKEN>& tokens, FUNCTIONMAP *functions, VARIABLEMAP *variables);
-		static std::vector<TOKEN> eval_parentheses(std::vector<TOKEN>& tokens,
-			FUNCTIONMAP *functions, VARIABLEMAP *variables);
-		static std::vector<TOKEN> eval_conditionals(
-			std::vector<TOKEN>&tokens, FUNCTIONMAP *functions, VARIABLEMAP *variables);
-		static void process_rhs_token(std::vector<TOKEN>& tokens, size_t index1, size_t index2);
-		static std::vector<TOKEN> eval(
-			std::vector<TOKEN>& tokens, bool f_args, FUNCTIONMAP *functions, VARIABLEMAP *variables);
-		TOKEN evaluate(std::vector<TOKEN>& tokens, FUNCTIONMAP *functions, VARIABLEMAP *variables);
+		static TOKEN parse_operand(expr::lexer& lex);
+		static TOKEN parse_expr(expr::lexer& lex, int level);
+		static TOKEN parse_expr(const std::string& s);
+
+		// optimizer
+		static TOKEN operands_folded(const TOKEN& token, std::vector<std::string>& variables, std::vector<std::string>& functions);
+		static TOKEN fold(const TOKEN& token, std::vector<std::string>& variables, std::vector<std::string>& functions);
+		const bool assumptions_hold(FUNCTIONMAP *functions, VARIABLEMAP *variables) const;
+		const bool assumptions_hold(context& ctx, FUNCTIONMAP *functions, VARIABLEMAP *variables) const;
+		const bool assumptions_hold(context& ctx, FUNCTIONMAP *functions, const variable_store& variables) const;
 
 	};
 
@@ -1,58 +1,275 @@
 #pragma once
 
+#include <span>
+#include <string>
 #include <vector>
+#include <cstdint>
+#include <utility>
 #include <functional>
+#include <type_traits>
 #include "lowercase_map.hpp"
 #include "expr/variable.hpp"
 
 namespace expr {
 
 	typedef std::vector<expr::VARIABLE> FUNCTION_ARGS;
-	typedef std::function<expr::VARIABLE(const expr::FUNCTION_ARGS&)> FUNCTION;
+	typedef std::span<const expr::VARIABLE> FUNCTION_ARGS_VIEW;
+
+	class FUNCTION;
+
+	// result of pure function depends only on its arguments, result of
+	// per tick function is same for same arguments while time of
+	// evaluation is same, volatile function may return anything.
+	// Evaluator memoizes results of pure and per tick calls
+	enum PURITY { F_VOLATILE, F_PER_TICK, F_PURE };
+
+	namespace functions {
+		template <typename R, typename... A, typename F>
+		expr::FUNCTION typed(F f, R(*)(A...));
+	}
+
+	// array entry points of numeric functions, result[i] is function of row i
+	typedef void (*ARRAY_FUNCTION1)(std::span<const double>, std::span<double>);
+	typedef void (*ARRAY_FUNCTION2)(std::span<const double>, std::span<const double>, std::span<double>);
+
+	// numeric function of 1 or 2 arguments with array entry point, f.e.
+	// vectorized(pure(typed<double(double)>(f)), array_f). Array entry
+	// point must give same results as f, result may be same array as an
+	// argument
+	expr::FUNCTION vectorized(expr::FUNCTION f, expr::ARRAY_FUNCTION1 array);
+	expr::FUNCTION vectorized(expr::FUNCTION f, expr::ARRAY_FUNCTION2 array);
+
+	// callable of expression. Functions taking FUNCTION_ARGS get their
+	// arguments copied to a vector, native functions read them directly
+	// from evaluator's stack. Typed functions (see expr::typed) are native
+	// functions with fixed count of arguments
+	class FUNCTION {
+
+	private:
+		std::function<expr::VARIABLE(const expr::FUNCTION_ARGS&)> _boxed;
+		std::function<expr::VARIABLE(expr::FUNCTION_ARGS_VIEW)> _native;
+		void (*_numeric)() = nullptr;
+		void (*_array)() = nullptr;
+		int _arity = -1;
+		PURITY _purity = F_VOLATILE;
+		uint64_t _generation = next_generation();
+
+		static uint64_t next_generation();
+
+		template <typename R, typename... A, typename F>
+		friend expr::FUNCTION expr::functions::typed(F f, R(*)(A...));
+		friend expr::FUNCTION expr::vectorized(expr::FUNCTION f, expr::ARRAY_FUNCTION1 array);
+		friend expr::FUNCTION expr::vectorized(expr::FUNCTION f, expr::ARRAY_FUNCTION2 array);
+
+	public:
+
+		const bool is_native() const;
+		const int arity() const; // -1 when function accepts any count of arguments
+
+		const PURITY purity() const;
+		void set_purity(const PURITY purity);
+
+		// unique to each constructed function, copies share it. Function
+		// that is replaced in a map keeps its address, but not generation
+		const uint64_t generation() const;
+
+		// typed function of 0 to 4 double arguments with double result
+		// can be called with numbers, without conversions to VARIABLE
+		const bool is_numeric() const {
+			return this -> _numeric != nullptr;
+		}
+
+		double numeric(const double *args) const {
+
+			switch ( this -> _arity ) {
+				case 0: return ((double(*)())this -> _numeric)();
+				case 1: return ((double(*)(double))this -> _numeric)(args[0]);
+				case 2: return ((double(*)(double, double))this -> _numeric)(args[0], args[1]);
+				case 3: return ((double(*)(double, double, double))this -> _numeric)(args[0], args[1], args[2]);
+				default: return ((double(*)(double, double, double, double))this -> _numeric)(args[0], args[1], args[2], args[3]);
+			}
+		}
+
+		// numeric function of 1 or 2 arguments with an array entry point,
+		// evaluator applies it to arrays of arguments at once
+		const bool is_vectorized() const {
+			return this -> _array != nullptr;
+		}
+
+		// result[i] is numeric() of args[0][i] ... args[arity - 1][i]
+		void numeric(const double *const *args, std::span<double> result) const {
+
+			if ( this -> _arity == 1 )
+				((expr::ARRAY_FUNCTION1)this -> _array)({ args[0], result.size() }, result);
+			else ((expr::ARRAY_FUNCTION2)this -> _array)({ args[0], result.size() }, { args[1], result.size() }, result);
+		}
+
+		expr::VARIABLE operator()(const expr::FUNCTION_ARGS& args) const;
+		expr::VARIABLE operator()(expr::FUNCTION_ARGS_VIEW args) const;
+
+		FUNCTION();
+		FUNCTION(std::function<expr::VARIABLE(expr::FUNCTION_ARGS_VIEW)> f, const int arity);
+
+		template <typename F> requires ( !std::is_same_v<std::remove_cvref_t<F>, expr::FUNCTION> &&
+			std::is_invocable_r_v<expr::VARIABLE, F, expr::FUNCTION_ARGS_VIEW> )
+		FUNCTION(F f) : _native(std::move(f)) {}
+
+		template <typename F> requires ( !std::is_same_v<std::remove_cvref_t<F>, expr::FUNCTION> &&
+			!std::is_invocable_r_v<expr::VARIABLE, F, expr::FUNCTION_ARGS_VIEW> &&
+			std::is_invocable_r_v<expr::VARIABLE, F, const expr::FUNCTION_ARGS&> )
+		FUNCTION(F f) : _boxed(std::move(f)) {}
+	};
+
 	typedef common::lowercase_map<expr::FUNCTION> FUNCTIONMAP;
 
 	namespace functions {
 
-		expr::VARIABLE time_unixtime(const expr::FUNCTION_ARGS& args);
-		expr::VARIABLE time_hour(const expr::FUNCTION_ARGS& args);
-		expr::VARIABLE time_min(const expr::FUNCTION_ARGS& args);
-		expr::VARIABLE time_sec(const expr::FUNCTION_ARGS& args);
-
-		expr::VARIABLE date_day(const expr::FUNCTION_ARGS& args);
-		expr::VARIABLE date_month(const expr::FUNCTION_ARGS& args);
-		expr::VARIABLE date_year(const expr::FUNCTION_ARGS& args);
-		expr::VARIABLE date_weekday(const expr::FUNCTION_ARGS& args);
-		expr::VARIABLE date_day_name(const expr::FUNCTION_ARGS& args);
-
-		expr::VARIABLE strftime(const expr::FUNCTION_ARGS& args);
-
-		expr::VARIABLE to_string(const expr::FUNCTION_ARGS& args);
-		expr::VARIABLE to_double(const expr::FUNCTION_ARGS& args);
-		expr::VARIABLE to_int(const expr::FUNCTION_ARGS& args);
-		expr::VARIABLE to_bool(const expr::FUNCTION_ARGS& args);
-
-		expr::VARIABLE is_odd(const expr::FUNCTION_ARGS& args);
-		expr::VARIABLE is_even(const expr::FUNCTION_ARGS& args);
-
-		expr::VARIABLE sqrt(const expr::FUNCTION_ARGS& args);
-		expr::VARIABLE exp(const expr::FUNCTION_ARGS& args);
-		expr::VARIABLE ln(const expr::FUNCTION_ARGS& args);
-		expr::VARIABLE log(const expr::FUNCTION_ARGS& args);
-		expr::VARIABLE sin(const expr::FUNCTION_ARGS& args);
-		expr::VARIABLE cos(const expr::FUNCTION_ARGS& args);
-		expr::VARIABLE tan(const expr::FUNCTION_ARGS& args);
-		expr::VARIABLE min(const expr::FUNCTION_ARGS& args);
-		expr::VARIABLE max(const expr::FUNCTION_ARGS& args);
-		expr::VARIABLE floor(const expr::FUNCTION_ARGS& args);
-		expr::VARIABLE ceil(const expr::FUNCTION_ARGS& args);
-		expr::VARIABLE round(const expr::FUNCTION_ARGS& args);
-
-		expr::VARIABLE strlen(const expr::FUNCTION_ARGS& args);
-		expr::VARIABLE to_upper(const expr::FUNCTION_ARGS& args);
-		expr::VARIABLE to_lower(const expr::FUNCTION_ARGS& args);
-		expr::VARIABLE substr(const expr::FUNCTION_ARGS& args);
+		// argument conversion of typed functions, missing arguments are 0, '' or null
+		double to_number(const expr::VARIABLE& v);
+
+		template <typename T> struct argument;
+
+		template <> struct argument<double> {
+			static double get(const expr::VARIABLE *v) {
+				if ( v == nullptr ) return 0;
+				else if ( const double *d = std::get_if<double>(v)) return *d;
+				return expr::functions::to_number(*v);
+			}
+		};
+
+		template <> struct argument<int> {
+			static int get(const expr::VARIABLE *v) {
+				return (int)argument<double>::get(v);
+			}
+		};
+
+		template <> struct argument<bool> {
+			static bool get(const expr::VARIABLE *v) {
+				return argument<double>::get(v) != 0;
+			}
+		};
+
+		template <> struct argument<std::string> {
+			static std::string get(const expr::VARIABLE *v) {
+				return v == nullptr ? std::string("") : v -> to_string();
+			}
+		};
+
+		template <> struct argument<expr::VARIABLE> {
+			static const expr::VARIABLE& get(const expr::VARIABLE *v) {
+				static const expr::VARIABLE null;
+				return v == nullptr ? null : *v;
+			}
+		};
+
+		template <typename R, typename... A, typename F, size_t... I>
+		expr::VARIABLE invoke(const F& f, expr::FUNCTION_ARGS_VIEW args, std::index_sequence<I...>) {
+			return expr::VARIABLE(static_cast<R>(f(argument<std::remove_cvref_t<A>>::get(I < args.size() ? &args[I] : nullptr)...)));
+		}
+
+		template <typename R, typename... A, typename F>
+		expr::FUNCTION typed(F f, R(*)(A...)) {
+
+			void (*numeric)() = nullptr;
+
+			if constexpr ( std::is_same_v<R, double> && ( std::is_same_v<A, double> && ... ) &&
+				sizeof...(A) <= 4 && std::is_convertible_v<F, double(*)(A...)> )
+				numeric = (void(*)())static_cast<double(*)(A...)>(f);
+
+			expr::FUNCTION function([f = std::move(f)](expr::FUNCTION_ARGS_VIEW args) {
+				return expr::functions::invoke<R, A...>(f, args, std::index_sequence_for<A...>{});
+			}, (int)sizeof...(A));
+
+			function._numeric = numeric;
+			return function;
+		}
+	}
+
+	// native function with signature SIGNATURE, f.e. typed<double(double, double)>(f),
+	// arguments are converted to parameter types and result to VARIABLE
+	template <typename SIGNATURE, typename F>
+	expr::FUNCTION typed(F f) {
+		return expr::functions::typed(std::move(f), (SIGNATURE*)nullptr);
+	}
+
+	// function annotated as pure or per tick, f.e. pure(typed<double(double)>(f))
+	expr::FUNCTION pure(expr::FUNCTION f);
+	expr::FUNCTION per_tick(expr::FUNCTION f);
+
+	template <typename SIGNATURE, typename F>
+	void register_function(expr::FUNCTIONMAP& functions, const std::string& name, F f, const expr::PURITY purity = expr::F_VOLATILE) {
+		functions[name] = expr::typed<SIGNATURE>(std::move(f));
+		functions[name].set_purity(purity);
+	}
+
+	namespace functions {
+
+		double time_unixtime();
+		double time_hour();
+		double time_min();
+		double time_sec();
+
+		double date_day();
+		double date_month();
+		double date_year();
+		double date_weekday();
+		std::string date_day_name();
+
+		expr::VARIABLE strftime(expr::FUNCTION_ARGS_VIEW args);
+
+		std::string to_string(const expr::VARIABLE& v);
+		double to_double(double d);
+		double to_int(double d);
+		bool to_bool(double d);
+
+		bool is_odd(double d);
+		bool is_even(double d);
+
+		double sqrt(double d);
+		double exp(double d);
+		double ln(double d);
+		double log(double d);
+		double sin(double d);
+		double cos(double d);
+		double tan(double d);
+		double min(double d1, double d2);
+		double max(double d1, double d2);
+		double floor(double d);
+		double ceil(double d);
+		double round(double d);
+
+		// array entry points of math builtins and ^ operator, results are
+		// those of scalar functions. With EXPR_LIBMVEC, sin, cos, tan, exp,
+		// ln, log and pow use vector math library of glibc on cpus with
+		// avx2. Its results are within 4 ulp of scalar ones, so batch and
+		// row by row results of those builtins may differ in last bits.
+		// errno is set like scalar functions set it
+		namespace arrays {
+
+			void sqrt(std::span<const double> d, std::span<double> result);
+			void exp(std::span<const double> d, std::span<double> result);
+			void ln(std::span<const double> d, std::span<double> result);
+			void log(std::span<const double> d, std::span<double> result);
+			void sin(std::span<const double> d, std::span<double> result);
+			void cos(std::span<const double> d, std::span<double> result);
+			void tan(std::span<const double> d, std::span<double> result);
+			void min(std::span<const double> d1, std::span<const double> d2, std::span<double> result);
+			void max(std::span<const double> d1, std::span<const double> d2, std::span<double> result);
+			void floor(std::span<const double> d, std::span<double> result);
+			void ceil(std::span<const double> d, std::span<double> result);
+			void round(std::span<const double> d, std::span<double> result);
+			void pow(std::span<const double> d1, std::span<const double> d2, std::span<double> result);
+		}
+
+		double strlen(const expr::VARIABLE& v);
+		std::string to_upper(const std::string& s);
+		std::string to_lower(const std::string& s);
+		expr::VARIABLE substr(expr::FUNCTION_ARGS_VIEW args);
 
 		extern expr::FUNCTIONMAP builtin_functions;
+
+		// true for pure builtins
+		const bool is_pure(const std::string& name);
 	}
 
 }
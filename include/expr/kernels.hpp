@@ -0,0 +1,46 @@
+#pragma once
+
+#include <span>
+#include <string>
+#include "expr/token.hpp"
+
+namespace expr {
+
+	namespace kernels {
+
+		enum ISA {
+			ISA_GENERIC,	// vectors of compiler, 2 lanes
+			ISA_SSE2,
+			ISA_AVX2,
+			ISA_AVX512
+		};
+
+		// instruction set of kernels, best one supported by cpu is
+		// selected on first use. select() changes it, instruction set
+		// that cpu does not support is not selected
+		const ISA isa();
+		const bool select(const ISA isa);
+		const bool supported(const ISA isa);
+
+		// operators that kernels apply, others need string operands
+		const bool is_binary(const OP op);
+		const bool is_unary(const OP op);
+
+		// result[i] = a[i] op b[i] for rows of result, result may be
+		// a or b. Results are bit-identical to expr::ops, except that
+		// a NaN result is only NaN where expr::ops gives NaN: sign and
+		// payload of NaN from two NaN operands depend on operand order
+		// that compiler chooses. Math errors are tested once for each
+		// block of rows and rows of block with an error, or division by
+		// zero, are applied again with expr::ops. False when op is not
+		// numeric
+		const bool binary(const OP op, std::span<const double> a, std::span<const double> b, std::span<double> result);
+
+		// result[i] = op a[i], for -, ! and !!
+		const bool unary(const OP op, std::span<const double> a, std::span<double> result);
+
+	} // end of namespace kernels
+
+} // end of namespace expr
+
+const std::string describe(const expr::kernels::ISA& isa);
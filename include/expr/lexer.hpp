@@ -0,0 +1,54 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include "expr/token.hpp"
+
+namespace expr {
+
+	enum LEX {
+		L_END,
+		L_NAME, L_NUMBER, L_STRING, L_OPERATOR,
+		L_LPAREN, L_RPAREN, L_QUESTION, L_COLON,
+		L_UNKNOWN
+	};
+
+	// lexeme does not own any text, it points to lexer's source
+	// with offset and length
+	struct LEXEME {
+
+		LEX type = L_END;
+		OP op = OP_UNDEF;
+		size_t offset = 0;
+		size_t length = 0;
+		bool space = false; // whitespace before lexeme
+		bool escaped = false; // string literal with escape sequences
+	};
+
+	class lexer {
+
+	private:
+		std::string_view _src;
+		size_t _pos = 0;
+		LEXEME _next;
+		bool _peeked = false;
+
+		LEXEME scan();
+
+	public:
+
+		const std::string_view source() const;
+		const size_t position() const;
+
+		const LEXEME next();
+		const LEXEME& peek();
+
+		const std::string_view text(const LEXEME& l) const;
+		const double number(const LEXEME& l) const;
+		const std::string string(const LEXEME& l) const;
+
+		lexer(std::string_view src);
+
+	};
+
+} // end of namespace expr
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include "expr/variable.hpp"
+#include "expr/value.hpp"
+#include "expr/cache_stats.hpp"
+
+namespace expr {
+
+	class context;
+	class FUNCTION;
+
+	// results of pure and per tick function calls of a context, by call
+	// site and values of arguments. Call site is an instruction of a
+	// program. Table is direct mapped, call replaces result of other
+	// call that maps to same entry. Calls with more than MAX_ARGS
+	// arguments are not memoized. Function is identified by its
+	// generation, so results of a replaced function are not used
+	class memo {
+
+	private:
+		struct ENTRY {
+
+			uint64_t site = 0; // 0 when entry is free
+			uint64_t function = 0; // generation of function
+			uint64_t tick = 0; // 0 for pure functions
+			size_t argc = 0;
+			std::array<VARIABLE, 4> args;
+			VARIABLE result;
+		};
+
+		std::vector<ENTRY> _entries;
+		size_t _capacity;
+		size_t _size = 0;
+		uint64_t _hits = 0;
+		uint64_t _misses = 0;
+		uint64_t _evictions = 0;
+
+		ENTRY* entry(const context& ctx, const uint64_t site, const FUNCTION *f, const value *argv, const size_t argc);
+
+	public:
+
+		static constexpr size_t MAX_ARGS = 4;
+
+		// memoized result of call, nullptr when call is not in memo
+		const VARIABLE* find(const context& ctx, const uint64_t site, const FUNCTION *f, const uint64_t tick, const value *argv, const size_t argc);
+		void store(const context& ctx, const uint64_t site, const FUNCTION *f, const uint64_t tick, const value *argv, const size_t argc, const value result);
+
+		const CACHE_STATS stats() const;
+		void resize(const size_t capacity); // rounded up to power of 2, 0 disables memo
+		void clear();
+
+		memo(const size_t capacity = 256);
+
+	};
+
+} // end of namespace expr
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+namespace expr {
+
+	// scalar semantics of operators, shared by TOKEN
+	// helpers and evaluator
+	namespace ops {
+
+		double SGN(const double n);
+		double OR(const double n1, const double n2);
+		double AND(const double n1, const double n2);
+		double NOT(const double n);
+		double NNOT(const double n);
+		double ADD(const double n1, const double n2);
+		double SUB(const double n1, const double n2);
+		double MUL(const double n1, const double n2);
+		double DIV(const double n1, const double n2);
+		double MOD(const double n1, const double n2);
+		double POW(const double n1, const double n2);
+		double NEQ(const double n1, const double n2);
+		double NNE(const double n1, const double n2);
+		double NLT(const double n1, const double n2);
+		double NLE(const double n1, const double n2);
+		double NGT(const double n1, const double n2);
+		double NGE(const double n1, const double n2);
+
+		std::string CAT(std::string_view s1, std::string_view s2);
+		double SEQ(std::string_view s1, std::string_view s2);
+		double SNE(std::string_view s1, std::string_view s2);
+		double SLT(std::string_view s1, std::string_view s2);
+		double SLE(std::string_view s1, std::string_view s2);
+		double SGT(std::string_view s1, std::string_view s2);
+		double SGE(std::string_view s1, std::string_view s2);
+	}
+
+} // end of namespace expr
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <list>
+#include <mutex>
+#include <memory>
+#include <string>
+#include <cstdint>
+#include <utility>
+#include <string_view>
+#include <unordered_map>
+#include "expr/expression.hpp"
+#include "expr/cache_stats.hpp"
+
+namespace expr {
+
+	// parsed expressions by their source, least recently used expression
+	// is removed when cache is full. Cached expressions are not modified,
+	// they can be evaluated from many threads at the same time
+	class parse_cache {
+
+	private:
+		typedef std::pair<std::string, std::shared_ptr<const expr::expression>> ENTRY;
+
+		mutable std::mutex _mutex;
+		std::list<ENTRY> _entries; // most recently used first
+		std::unordered_map<std::string_view, std::list<ENTRY>::iterator> _index;
+		size_t _capacity;
+		uint64_t _hits = 0;
+		uint64_t _misses = 0;
+		uint64_t _evictions = 0;
+
+		void evict();
+
+	public:
+
+		// parsed expression of source, parsed and added when not cached
+		std::shared_ptr<const expr::expression> get(const std::string& source);
+
+		const CACHE_STATS stats() const;
+		void resize(const size_t capacity);
+		void clear();
+
+		static parse_cache& global();
+
+		parse_cache(const size_t capacity = 1024);
+		parse_cache(const parse_cache&) = delete;
+		parse_cache& operator =(const parse_cache&) = delete;
+
+	};
+
+} // end of namespace expr
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <span>
+#include <cstdint>
+#include "expr/variable.hpp"
+#include "expr/function.hpp"
+#include "expr/token.hpp"
+#include "expr/context.hpp"
+#include "expr/symbols.hpp"
+#include "expr/value.hpp"
+#include "expr/variable_store.hpp"
+
+namespace expr {
+
+	enum OPCODE {
+		I_CONST,	// push constant a
+		I_LOAD,		// push variable a, constant b when variable is not set
+		I_SLOT,		// push variable from slot a
+		I_CALL,		// call function a with b arguments from stack
+		I_LINKED,	// call linked function a with b arguments from stack
+		I_UNARY,	// apply operator to top of stack
+		I_BINARY,	// apply operator to 2 topmost values of stack
+		I_JUMP,		// continue from instruction a
+		I_JUMP_FALSE,	// pop condition, continue from instruction a when it is false
+		I_AND,		// when top of stack is false, replace it with 0 and continue from a, pop otherwise
+		I_OR		// when top of stack is true, replace it with 1 and continue from a, pop otherwise
+	};
+
+	struct INSTRUCTION {
+
+		OPCODE code;
+		OP op = OP_UNDEF;
+		uint32_t a = 0;
+		uint32_t b = 0;
+	};
+
+	// expression tree compiled to flat postfix code, evaluated with
+	// a value stack from evaluation context. Program is not modified
+	// when run
+	class program {
+
+	friend class batch;
+
+	private:
+		std::vector<INSTRUCTION> _code;
+		std::vector<value> _constants; // strings are indexes to _strings
+		std::vector<std::string> _strings; // string literals of program
+		std::vector<SYMBOL> _names;
+		std::vector<FUNCTION*> _handles;
+		std::string _set_variable;
+		SYMBOL _set_symbol = symbols::NONE; // case folded name of set variable
+		int _set_slot = -1;
+		uint64_t _id = 0; // call sites in memo are id and index of instruction, copies share id
+
+		size_t _depth = 0;
+		size_t _max_depth = 0;
+
+		const uint32_t add_constant(const VARIABLE& v);
+		const uint32_t name(const std::string& s);
+		void emit(const INSTRUCTION& i, const int stack_change);
+		void compile(const TOKEN& token);
+		value execute(context& ctx, FUNCTIONMAP *functions, VARIABLEMAP *variables, std::span<VARIABLE> slots, const variable_store *store = nullptr) const;
+
+	public:
+
+		const std::vector<INSTRUCTION>& code() const;
+		const std::vector<value>& constants() const;
+		const VARIABLE constant(const uint32_t index) const;
+		const std::vector<SYMBOL>& names() const; // case folded, interned to symbols::global()
+		const std::string set_variable() const;
+		const bool empty() const;
+
+		TOKEN run(context& ctx, FUNCTIONMAP *functions = nullptr, VARIABLEMAP *variables = nullptr, std::span<VARIABLE> slots = {}) const;
+		TOKEN run(FUNCTIONMAP *functions = nullptr, VARIABLEMAP *variables = nullptr, std::span<VARIABLE> slots = {}) const;
+
+		// variables are read from store, variable that is set is written to store
+		TOKEN run(context& ctx, FUNCTIONMAP *functions, variable_store& variables) const;
+
+		// result is assigned to result, string result reuses its storage
+		void run(context& ctx, FUNCTIONMAP *functions, VARIABLEMAP *variables, std::span<VARIABLE> slots, VARIABLE& result) const;
+
+		// copy of program that loads variables of schema from slots and
+		// other variables as if they were not set, names of those are
+		// added to unbound
+		const program bind(const SCHEMA& schema, std::vector<std::string>& unbound) const;
+
+		// resolves function calls to user functions or builtins, names
+		// of unknown functions are added to unknown and their calls
+		// result null. Program must be linked again, if functions are
+		// added to, or removed from maps
+		void link(FUNCTIONMAP *functions, std::vector<std::string>& unknown);
+
+		// value of variable that is not set: named constants or empty string
+		static const bool is_named_constant(const std::string& name);
+		static const VARIABLE named_constant(const std::string& name);
+
+		program();
+		program(const TOKEN& root);
+
+	};
+
+} // end of namespace expr
+
+const std::string describe(const expr::OPCODE& code);
+const std::string describe(const expr::program& p);
@@ -66,6 +66,10 @@ namespace expr {
 		const std::string pretty(const std::string& key);
 		const expr::expression expression(const std::string& key);
 
+		// value of property expression e, def is returned when result is null or empty
+		static expr::RESULT value(const expr::expression& e, expr::FUNCTIONMAP *f, expr::VARIABLEMAP *v,
+			const std::variant<double, std::string, std::nullptr_t>& def);
+
 	};
 
 	typedef common::lowercase_map<std::string> PROPERTYMAP;
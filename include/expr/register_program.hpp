@@ -0,0 +1,89 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "expr/variable.hpp"
+#include "expr/function.hpp"
+#include "expr/token.hpp"
+#include "expr/expression.hpp"
+#include "expr/symbols.hpp"
+
+namespace expr {
+
+	enum ROPCODE {
+		R_HALT,			// end of program, result is in register a
+		R_MOVE,			// dst = a
+		R_LOAD,			// dst = variable a, register b when variable is not set
+		R_CALL,			// dst = function a with b arguments from registers dst...
+		R_CALL0,		// dst = function a without arguments, builtin b
+		R_UNARY,		// dst = op a
+		R_BINARY,		// dst = a op b
+		R_LOAD_CMP_CONST,	// dst = variable a (or register b) op constant c, op is a comparator
+		R_LOAD_MUL_CONST,	// dst = variable a (or register b) * constant c
+		R_JUMP,			// continue from instruction a
+		R_JUMP_FALSE,		// continue from instruction b when register a is false
+		R_AND,			// when register a is false, set it to 0 and continue from instruction b
+		R_OR			// when register a is true, set it to 1 and continue from instruction b
+	};
+
+	struct RINSTRUCTION {
+
+		ROPCODE code;
+		OP op = OP_UNDEF;
+		uint32_t dst = 0;
+		uint32_t a = 0;
+		uint32_t b = 0;
+		uint32_t c = 0;
+	};
+
+	// second execution engine: expression lowered to register based
+	// code where constants are preloaded to registers and operands
+	// are addressed directly. Dispatch is a switch, or threaded with
+	// GCC's labels as values when EXPR_THREADED_DISPATCH is defined.
+	// Superinstructions are not emitted when EXPR_NO_SUPERINSTRUCTIONS
+	// is defined. Program is not modified when run, registers are in
+	// frames of running thread.
+	class register_program {
+
+	private:
+		std::vector<RINSTRUCTION> _code;
+		std::vector<VARIABLE> _registers;
+		std::vector<SYMBOL> _names;
+		std::vector<FUNCTION*> _builtins;
+		std::vector<const void*> _handlers; // labels of instructions with threaded dispatch
+		std::string _set_variable;
+		uint64_t _id = 0; // copies share id, frame of thread keeps registers of last id
+
+		size_t _constants = 0;
+		size_t _temporaries = 0;
+
+		const uint32_t constant(const VARIABLE& v);
+		const uint32_t temporary(const uint32_t index);
+		const uint32_t name(const std::string& s);
+		void emit(const RINSTRUCTION& i);
+		const uint32_t lower(const TOKEN& token, const uint32_t target);
+		void lower_into(const TOKEN& token, const uint32_t target);
+		TOKEN execute(FUNCTIONMAP *functions, VARIABLEMAP *variables, std::vector<const void*> *handlers_of) const;
+
+	public:
+
+		const std::vector<RINSTRUCTION>& code() const;
+		const std::vector<SYMBOL>& names() const;
+		const size_t constants() const;
+		const size_t registers() const;
+		const std::string set_variable() const;
+		const bool empty() const;
+
+		TOKEN run(FUNCTIONMAP *functions = nullptr, VARIABLEMAP *variables = nullptr) const;
+
+		register_program();
+		register_program(const TOKEN& root);
+		register_program(const expression& e);
+
+	};
+
+} // end of namespace expr
+
+const std::string describe(const expr::ROPCODE& code);
+const std::string describe(const expr::register_program& p);
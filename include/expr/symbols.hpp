@@ -0,0 +1,66 @@
+#pragma once
+
+#include <bit>
+#include <array>
+#include <memory>
+#include <string>
+#include <cstdint>
+#include <string_view>
+#include <shared_mutex>
+#include <unordered_map>
+
+namespace expr {
+
+	typedef uint32_t SYMBOL;
+
+	// intern table of identifiers. Every distinct name is stored once
+	// and has a stable id, so expressions that use same names share them
+	// and compare names by their ids. Identifiers are case folded like
+	// keys of common::lowercase_map. String literals are not interned,
+	// they are kept by trees and programs that use them. Names are never
+	// removed, reading string of an id does not lock. Chunk k holds
+	// CHUNK_SIZE << k names, so table grows without moving names and
+	// has no fixed capacity
+	class symbols {
+
+	private:
+		static constexpr size_t CHUNK_BITS = 10;
+		static constexpr size_t CHUNK_SIZE = 1 << CHUNK_BITS;
+		static constexpr size_t CHUNKS = 33 - CHUNK_BITS;
+
+		mutable std::shared_mutex _mutex;
+		std::array<std::unique_ptr<std::string[]>, CHUNKS> _chunks;
+		std::unordered_map<std::string_view, SYMBOL> _ids;
+		size_t _bytes = 0;
+
+	public:
+
+		static constexpr SYMBOL NONE = UINT32_MAX;
+
+		// id of name, name is added when it is not in table
+		const SYMBOL intern(std::string_view s);
+
+		// id of case folded name
+		const SYMBOL identifier(std::string_view name);
+
+		// id of string or NONE, table is not modified
+		const SYMBOL find(std::string_view s) const;
+
+		const std::string& string(const SYMBOL id) const {
+			size_t n = (size_t)id + CHUNK_SIZE;
+			size_t chunk = std::bit_width(n) - CHUNK_BITS - 1;
+			return this -> _chunks[chunk][n - ( CHUNK_SIZE << chunk )];
+		}
+
+		const size_t size() const;
+		const size_t bytes() const; // bytes used by names
+
+		static symbols& global();
+
+		symbols();
+		symbols(const symbols&) = delete;
+		symbols& operator =(const symbols&) = delete;
+
+	};
+
+} // end of namespace expr
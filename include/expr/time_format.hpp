@@ -0,0 +1,46 @@
+#pragma once
+
+#include <ctime>
+#include <string>
+#include <vector>
+
+namespace expr {
+
+	// strftime format compiled to fields. Numbers of %Y %m %d %H %M %S
+	// and %j are written with std::to_chars. Names of %a, %b and %h are
+	// written from tables when LC_TIME is C or POSIX, with other locales
+	// they are formatted with strftime of libc like other conversions
+	class time_format {
+
+	private:
+		enum FIELD_TYPE { TEXT, YEAR, MONTH, DAY, HOUR, MINUTE, SECOND, YEAR_DAY, WEEKDAY_NAME, MONTH_NAME, LIBC };
+
+		struct FIELD {
+
+			FIELD_TYPE type;
+			std::string text; // literal text or format of libc conversion
+		};
+
+		std::string _format;
+		std::vector<FIELD> _fields;
+
+		void text(const std::string& s);
+
+	public:
+
+		const std::string& source() const;
+
+		// tm formatted to out, storage of out is reused
+		void format(const std::tm& tm, std::string& out) const;
+		const std::string format(const std::tm& tm) const;
+
+		// compiled format from small cache of calling thread, format is
+		// compiled when it is not cached
+		static const time_format& cached(const std::string& format);
+
+		time_format();
+		time_format(const std::string& format);
+
+	};
+
+} // end of namespace expr
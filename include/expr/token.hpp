@@ -7,6 +7,7 @@
 namespace expr {
 
 	class expression;
+	class tree;
 
 	enum TYPE {
 		T_UNDEF,
@@ -28,6 +29,7 @@ namespace expr {
 	class TOKEN {
 
 	friend class expression;
+	friend class tree;
 
 	private:
 		TYPE	_type	= T_UNDEF;
@@ -59,10 +61,10 @@ namespace expr {
 		const std::string raw() const;
 		const std::variant<double, std::string, std::nullptr_t> value() const;
 		const std::string name() const;
-		const std::vector<TOKEN> args() const;
-		const std::vector<TOKEN> child() const;
-		const std::vector<TOKEN> cond1() const;
-		const std::vector<TOKEN> cond2() const;
+		const std::vector<TOKEN>& args() const;
+		const std::vector<TOKEN>& child() const;
+		const std::vector<TOKEN>& cond1() const;
+		const std::vector<TOKEN>& cond2() const;
 
 		const double raw_double() const;
 		const int raw_int() const;
@@ -102,6 +104,7 @@ namespace expr {
 		static TOKEN NUMBER(int n);
 		static TOKEN NUMBER(double n);
 		static TOKEN STRING(const std::string& s);
+		static TOKEN STRING(std::string&& s);
 
 		static TOKEN SGN(const double n);
 		static TOKEN OR(const double n1, const double n2);
@@ -143,6 +146,7 @@ const std::string describe(const expr::TYPE& type);
 const std::string describe(const expr::OP& op);
 const std::string describe(const expr::TOKEN& token);
 const std::string describe(const std::vector<expr::TOKEN>& tokens);
+const std::string describe_expr(const expr::TOKEN& token);
 
 std::ostream& operator <<(std::ostream& os, expr::TYPE const& t);
 std::ostream& operator <<(std::ostream& os, expr::OP const& o);
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <string_view>
+#include "expr/token.hpp"
+#include "expr/symbols.hpp"
+
+namespace expr {
+
+	// node of flat expression tree. Children of node are consecutive,
+	// conditional has 3 children: condition, then and else branch
+	struct NODE {
+
+		uint8_t type = T_UNDEF;
+		uint8_t op = OP_UNDEF;
+		uint16_t count = 0;	// number of children
+		uint32_t first = 0;	// index of first child
+
+		union {
+			double number = 0;	// T_NUMBER
+			SYMBOL text;		// index of T_STRING value, name of T_VARIABLE or T_FUNCTION
+		};
+	};
+
+	// expression tree stored as contiguous array of nodes, root node
+	// is first. Names are interned to global symbol table, strings are
+	// kept with tree
+	class tree {
+
+	private:
+		std::vector<NODE> _nodes;
+		std::vector<std::string> _strings;
+
+		const size_t count(const TOKEN& token) const;
+		void store(const uint32_t index, const TOKEN& token);
+		TOKEN token(const uint32_t index) const;
+
+	public:
+
+		const std::vector<NODE>& nodes() const;
+		const std::string_view text(const NODE& node) const;
+		const bool empty() const;
+
+		// bytes used by nodes and strings, interned names are not included
+		const size_t size() const;
+
+		// tree converted back to tokens
+		TOKEN root() const;
+
+		tree();
+		tree(const TOKEN& root);
+
+	};
+
+} // end of namespace expr
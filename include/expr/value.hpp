@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+namespace expr {
+
+	// 8 byte value used by evaluator. Numbers are stored as doubles and
+	// null and strings in payload of NaNs that arithmetic never produces,
+	// NaN results are stored as quiet NaNs without payload. String is an index to
+	// string table of evaluation context. Values are converted to and
+	// from VARIABLE when they pass to functions or back to caller
+	class value {
+
+	private:
+		uint64_t _bits;
+
+		static constexpr uint64_t TAG_MASK = 0xFFFF000000000000;
+		static constexpr uint64_t TAG_NULL = 0xFFF9000000000000;
+		static constexpr uint64_t TAG_STRING = 0xFFFA000000000000;
+		static constexpr uint64_t CANONICAL_NAN = 0x7FF8000000000000;
+		static constexpr uint64_t SIGN = 0x8000000000000000;
+
+		explicit value(const uint64_t bits) : _bits(bits) {}
+
+	public:
+
+		const bool is_number() const {
+			return ( this -> _bits & TAG_MASK ) < TAG_NULL;
+		}
+
+		const bool is_null() const {
+			return ( this -> _bits & TAG_MASK ) == TAG_NULL;
+		}
+
+		const bool is_string() const {
+			return ( this -> _bits & TAG_MASK ) == TAG_STRING;
+		}
+
+		const double number() const {
+			double d;
+			std::memcpy(&d, &this -> _bits, sizeof(double));
+			return d;
+		}
+
+		const uint32_t string() const {
+			return (uint32_t)this -> _bits;
+		}
+
+		static value NUMBER(const double d) {
+
+			uint64_t bits;
+			std::memcpy(&bits, &d, sizeof(double));
+
+			// payload of NaN is dropped, sign is kept
+			if ( d != d )
+				bits = ( bits & SIGN ) | CANONICAL_NAN;
+
+			return value(bits);
+		}
+
+		static value NULLPTR() {
+			return value(TAG_NULL);
+		}
+
+		static value STRING(const uint32_t index) {
+			return value(TAG_STRING | index);
+		}
+
+		value() : _bits(TAG_NULL) {}
+	};
+
+	static_assert(sizeof(value) == 8);
+
+} // end of namespace expr
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <string>
+#include <vector>
 #include <variant>
 #include <iostream>
 #include "lowercase_map.hpp"
@@ -28,6 +29,9 @@ namespace expr {
 		operator int() const;
 		operator std::string() const;
 
+		VARIABLE& operator =(const VARIABLE& other) = default;
+		VARIABLE& operator =(VARIABLE&& other) = default;
+
 		bool operator ==(const VAR_TYPE& type) const {
 			return this -> type() == type;
 		}
@@ -42,6 +46,10 @@ namespace expr {
 		const bool is_number() const;
 		const bool is_bool() const;
 
+		// equal type and value, numbers compare bitwise so 0 and -0 differ,
+		// NaN is same as NaN
+		const bool same(const VARIABLE& other) const;
+
 		std::string string_convertible() const;
 		std::string number_convertible() const;
 		std::string bool_convertible() const;
@@ -58,6 +66,7 @@ namespace expr {
 		VARIABLE(const double d);
 		VARIABLE(const std::string& s);
 		VARIABLE(const VARIABLE& other);
+		VARIABLE(VARIABLE&& other) = default;
 		VARIABLE(const std::variant<double, std::string, std::nullptr_t>& v);
 
 		const std::string describe() const;
@@ -74,4 +83,7 @@ namespace expr {
 
 	typedef common::lowercase_map<expr::VARIABLE> VARIABLEMAP;
 
+	// variable names in order of their slots
+	typedef std::vector<std::string> SCHEMA;
+
 } // end of namespace expr
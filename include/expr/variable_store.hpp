@@ -0,0 +1,71 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <unordered_map>
+#include "expr/variable.hpp"
+#include "expr/symbols.hpp"
+
+namespace expr {
+
+	// variables in dense slots, slots are looked up by symbol of case
+	// folded name. Every slot has version of its last change, writing a
+	// value that is same as current value does not change it, so users
+	// of store can compare versions and skip work when nothing changed.
+	// Slot of variable stays same, also when variable is erased
+	class variable_store {
+
+	private:
+		std::unordered_map<SYMBOL, size_t> _slots_of;
+		std::vector<std::string> _names;
+		std::vector<VARIABLE> _values;
+		std::vector<uint64_t> _versions;
+		std::vector<bool> _set;
+		uint64_t _version = 0;
+
+	public:
+
+		static constexpr size_t NONE = SIZE_MAX;
+
+		// slot of variable, slot of unset variable is added when name is not in store
+		const size_t slot(const std::string& name);
+		const size_t slot(const SYMBOL id);
+
+		// slot of variable or NONE, store is not modified
+		const size_t find(const std::string& name) const;
+		const size_t find(const SYMBOL id) const;
+
+		// value is stored, returns true and bumps version when value changed
+		const bool set(const std::string& name, const VARIABLE& value);
+		const bool set(const size_t slot, const VARIABLE& value);
+
+		// variable is unset, returns true when it was set
+		const bool erase(const std::string& name);
+		const bool erase(const size_t slot);
+
+		const bool contains(const std::string& name) const;
+		const bool is_set(const size_t slot) const;
+		const VARIABLE& get(const size_t slot) const;
+		const VARIABLE& operator [](const std::string& name) const; // null when not set
+		const std::string& name(const size_t slot) const;
+		const size_t size() const; // count of slots
+
+		const uint64_t version() const; // increased by every change
+		const uint64_t version(const size_t slot) const; // version of last change of slot, 0 if never set
+
+		// true when any variable changed after version
+		const bool changed_since(const uint64_t version) const;
+
+		// slots changed after version are added to slots, returns count of them
+		const size_t changed_since(const uint64_t version, std::vector<size_t>& slots) const;
+
+		// set variables are copied to m
+		void copy_to(expr::VARIABLEMAP& m) const;
+
+		variable_store();
+		variable_store(const expr::VARIABLEMAP& m);
+
+	};
+
+} // end of namespace expr
@@ -43,6 +43,7 @@ int main(int argc, char **argv) {
 	//s = "hello(1, hello(1, hello(1)), 1) + 1 + hello(1 + xxx)";
 	//s = "xxx";
 	//s = "hello(xxx)";
+	//s = "clamp01(xxx / 20) * 100";
 	//s = "xxx + ( 10 + xxx + xxx + hello(xxx))";
 	//s = "xxx + ( 10 + 10 )";
 	//s = "xxx + 10 + 10";
@@ -100,6 +101,10 @@ int main(int argc, char **argv) {
 		{ "hello", hello },
 	};
 
+	expr::register_function<double(double)>(functions, "clamp01", [](double d) {
+		return d < 0 ? 0.0 : ( d > 1 ? 1.0 : d );
+	});
+
 	expr::VARIABLEMAP variables = {
 		{ "xxx", (double)10.5 },
 		{ "bb", (double)1 },
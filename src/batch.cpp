@@ -0,0 +1,175 @@
+#include <utility>
+#include <algorithm>
+#include "common.hpp"
+#include "logger.hpp"
+#include "expr/batch.hpp"
+
+expr::batch::batch() {
+}
+
+expr::batch::batch(const expr::expression& e, expr::FUNCTIONMAP *functions) {
+
+	this -> _expression = e;
+	this -> _functions = functions;
+	this -> bind();
+}
+
+const int expr::batch::column(const std::string& name) const {
+
+	std::string s = common::to_lower(std::as_const(name));
+
+	for ( size_t i = 0; i < this -> _columns.size(); i++ )
+		if ( this -> _columns[i].name == s )
+			return (int)i;
+
+	return -1;
+}
+
+expr::batch::COLUMN& expr::batch::add(const std::string& name) {
+
+	if ( int i = this -> column(name); i != -1 )
+		return this -> _columns[i];
+
+	// new name changes schema, program is bound again
+	this -> _bound = false;
+	COLUMN& c = this -> _columns.emplace_back();
+	c.name = common::to_lower(std::as_const(name));
+	return c;
+}
+
+void expr::batch::bind(const std::string& name, std::span<const double> column) {
+
+	COLUMN& c = this -> add(name);
+	c.type = C_NUMBERS;
+	c.numbers = column;
+	c.strings = {};
+	c.scalar = expr::VARIABLE();
+}
+
+void expr::batch::bind(const std::string& name, std::span<const std::string> column) {
+
+	COLUMN& c = this -> add(name);
+	c.type = C_STRINGS;
+	c.numbers = {};
+	c.strings = column;
+	c.scalar = expr::VARIABLE();
+}
+
+void expr::batch::bind(const std::string& name, const expr::VARIABLE& scalar) {
+
+	COLUMN& c = this -> add(name);
+	c.type = C_SCALAR;
+	c.numbers = {};
+	c.strings = {};
+	c.scalar = scalar;
+}
+
+void expr::batch::clear() {
+
+	this -> _columns.clear();
+	this -> _bound = false;
+}
+
+void expr::batch::link(expr::FUNCTIONMAP *functions) {
+
+	this -> _functions = functions;
+	this -> bind();
+}
+
+void expr::batch::bind() {
+
+	const expr::expression& e = this -> _expression;
+
+	// folded program is used only if columns and functions do not shadow names it assumed
+	bool shadowed = !e.assumptions_hold(this -> _functions, nullptr) ||
+		std::any_of(e._assumed_variables.begin(), e._assumed_variables.end(),
+			[this](const std::string& name) { return this -> column(name) != -1; });
+
+	expr::SCHEMA schema;
+	std::vector<std::string> unbound;
+
+	for ( const COLUMN& c : this -> _columns )
+		schema.push_back(c.name);
+
+	this -> _unknown.clear();
+	this -> _program = ( shadowed ? e._unfolded : e._program ).bind(schema, unbound);
+	this -> _program.link(this -> _functions, this -> _unknown);
+
+	this -> _stack.resize(std::max(this -> _program._max_depth, (size_t)1));
+
+	for ( SLOT& s : this -> _stack ) {
+		s.numbers.resize(CHUNK);
+		s.values.resize(CHUNK);
+	}
+
+	// every branch nests at most once and allocates 2 selections
+	size_t branches = std::count_if(this -> _program._code.begin(), this -> _program._code.end(),
+		[](const expr::INSTRUCTION& in) {
+			return in.code == expr::I_JUMP_FALSE || in.code == expr::I_AND || in.code == expr::I_OR;
+		});
+
+	this -> _frames.resize(branches);
+	this -> _selections.resize(1 + 2 * branches);
+
+	for ( SELECTION& s : this -> _selections )
+		s.rows.resize(CHUNK);
+
+	this -> _within.rows.resize(CHUNK);
+	this -> _matched.rows.resize(CHUNK);
+	this -> _unmatched.rows.resize(CHUNK);
+
+	this -> _bound = true;
+}
+
+const bool expr::batch::check(const size_t rows) {
+
+	for ( const COLUMN& c : this -> _columns ) {
+
+		size_t size = c.type == C_NUMBERS ? c.numbers.size() :
+			( c.type == C_STRINGS ? c.strings.size() : rows );
+
+		if ( size < rows ) {
+			logger::error["evaluate"] << "batch of <" << this -> _expression.raw() << "> has " << rows <<
+				" rows, column " << c.name << " has " << size << std::endl;
+			return false;
+		}
+	}
+
+	if ( !this -> _bound )
+		this -> bind();
+
+	return true;
+}
+
+const std::vector<std::string>& expr::batch::unknown() const {
+	return this -> _unknown;
+}
+
+const size_t expr::batch::columns() const {
+	return this -> _columns.size();
+}
+
+const bool expr::batch::evaluate(std::span<double> results) {
+
+	return this -> evaluate(expr::context::local(), results);
+}
+
+const bool expr::batch::evaluate(std::span<expr::VARIABLE> results) {
+
+	return this -> evaluate(expr::context::local(), results);
+}
+
+const bool expr::batch::filter(const size_t rows, std::span<uint64_t> mask) {
+
+	return this -> filter(expr::context::local(), rows, mask);
+}
+
+const bool expr::batch::filter(const size_t rows, std::vector<uint32_t>& selected) {
+
+	return this -> filter(expr::context::local(), rows, selected);
+}
+
+const bool expr::batch::filter(std::span<const uint32_t> rows, std::vector<uint32_t>& selected) {
+
+	return this -> filter(expr::context::local(), rows, selected);
+}
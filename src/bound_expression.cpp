@@ -0,0 +1,84 @@
+#include <utility>
+#include <algorithm>
+#include "common.hpp"
+#include "logger.hpp"
+#include "expr/bound_expression.hpp"
+
+expr::bound_expression::bound_expression() {
+}
+
+expr::bound_expression::bound_expression(const expr::expression& e, const expr::SCHEMA& schema, expr::FUNCTIONMAP *functions) {
+
+	this -> _expression = e;
+	this -> _schema = schema;
+	this -> _functions = functions;
+	this -> bind();
+}
+
+void expr::bound_expression::bind() {
+
+	const expr::expression& e = this -> _expression;
+
+	// folded program is used only if schema and functions do not shadow names it assumed
+	bool shadowed = !e.assumptions_hold(this -> _functions, nullptr) ||
+		std::any_of(e._assumed_variables.begin(), e._assumed_variables.end(),
+			[this](const std::string& name) { return this -> slot(name) != -1; });
+
+	this -> _unbound.clear();
+	this -> _unknown.clear();
+	this -> _program = ( shadowed ? e._unfolded : e._program ).bind(this -> _schema, this -> _unbound);
+	this -> _program.link(this -> _functions, this -> _unknown);
+
+	for ( const std::string& name : this -> _unbound )
+		logger::vverbose["bind"] << "variable " << name << " is not in schema of <" <<
+			e.raw() << ">, it is evaluated as unset" << std::endl;
+}
+
+const expr::SCHEMA& expr::bound_expression::schema() const {
+	return this -> _schema;
+}
+
+const std::vector<std::string>& expr::bound_expression::unbound() const {
+	return this -> _unbound;
+}
+
+const int expr::bound_expression::slot(const std::string& name) const {
+
+	std::string s = common::to_lower(std::as_const(name));
+
+	for ( size_t i = 0; i < this -> _schema.size(); i++ )
+		if ( common::to_lower(std::as_const(this -> _schema[i])) == s )
+			return (int)i;
+
+	return -1;
+}
+
+const std::vector<std::string>& expr::bound_expression::unknown() const {
+	return this -> _unknown;
+}
+
+void expr::bound_expression::link(expr::FUNCTIONMAP *functions) {
+
+	this -> _functions = functions;
+	this -> bind();
+}
+
+const expr::program& expr::bound_expression::compiled() const {
+	return this -> _program;
+}
+
+expr::TOKEN expr::bound_expression::evaluate(std::span<expr::VARIABLE> slots) const {
+
+	return this -> evaluate(expr::context::local(), slots);
+}
+
+expr::TOKEN expr::bound_expression::evaluate(expr::context& ctx, std::span<expr::VARIABLE> slots) const {
+
+	if ( slots.size() < this -> _schema.size()) {
+		logger::error["evaluate"] << "bound expression needs " << this -> _schema.size() <<
+			" variable slots, " << slots.size() << " were given" << std::endl;
+		return expr::TOKEN::UNDEF();
+	}
+
+	return this -> _program.run(ctx, nullptr, nullptr, slots);
+}
@@ -0,0 +1,514 @@
+#include <utility>
+#include <algorithm>
+#include <unordered_set>
+#include "common.hpp"
+#include "logger.hpp"
+#include "expr/symbols.hpp"
+#include "expr/compiled_property_map.hpp"
+
+expr::compiled_property_map::compiled_property_map(expr::FUNCTIONMAP *f, expr::VARIABLEMAP *v) : _funcs(f), _vars(v) {
+}
+
+expr::compiled_property_map::compiled_property_map(const expr::PROPERTYMAP& m, expr::FUNCTIONMAP *f, expr::VARIABLEMAP *v) : _funcs(f), _vars(v) {
+
+	this -> load(m);
+}
+
+const expr::compiled_property_map::ENTRY* expr::compiled_property_map::entry(const std::string& key) const {
+
+	auto it = this -> _ids.find(common::to_lower(std::as_const(key)));
+	return it == this -> _ids.end() ? nullptr : &this -> _entries[it -> second];
+}
+
+// slot of variable in schema, variable is added when it is not in schema
+const size_t expr::compiled_property_map::slot(const expr::SYMBOL id) {
+
+	if ( auto it = this -> _slots_of.find(id); it != this -> _slots_of.end())
+		return it -> second;
+
+	const std::string& name = expr::symbols::global().string(id);
+
+	this -> _slots_of[id] = this -> _schema.size();
+	this -> _schema.push_back(name);
+	this -> _fallbacks.push_back(expr::program::named_constant(name));
+	return this -> _schema.size() - 1;
+}
+
+// binds program of entry to schema of map, variables it reads and sets
+// are added to schema. Folded program is not used, as folding assumed
+// that variables are not set
+void expr::compiled_property_map::bind(ENTRY& e) {
+
+	const expr::program& p = e.compiled._unfolded.empty() ? e.compiled._program : e.compiled._unfolded;
+	expr::symbols& symbols = expr::symbols::global();
+	std::vector<std::string> unbound, unknown;
+
+	e.reads.clear();
+	e.writes = expr::compiled_property_map::NONE;
+	e.impure = false;
+
+	for ( const expr::INSTRUCTION& in : p.code()) {
+
+		if ( in.code == expr::I_LOAD ) {
+
+			size_t slot = this -> slot(p.names()[in.a]);
+
+			if ( std::find(e.reads.begin(), e.reads.end(), slot) == e.reads.end())
+				e.reads.push_back(slot);
+
+		} else if ( in.code == expr::I_CALL || in.code == expr::I_LINKED ) {
+
+			const std::string& name = symbols.string(p.names()[in.a]);
+			const expr::FUNCTION *f = this -> _funcs != nullptr && this -> _funcs -> contains(name) ? &(*this -> _funcs)[name] :
+				expr::functions::builtin_functions.contains(name) ? &expr::functions::builtin_functions[name] : nullptr;
+
+			// per tick functions change between passes
+			if ( f != nullptr && f -> purity() != expr::F_PURE )
+				e.impure = true;
+		}
+	}
+
+	if ( !p.set_variable().empty())
+		e.writes = this -> slot(symbols.identifier(p.set_variable()));
+
+	e.bound = p.bind(this -> _schema, unbound);
+	e.bound.link(this -> _funcs, unknown);
+	e.pending = true;
+	this -> _sorted = false;
+}
+
+// compiles source of key with current generation, unless it is unchanged
+const bool expr::compiled_property_map::update(const std::string& key, const std::string& source) {
+
+	size_t id;
+
+	if ( auto it = this -> _ids.find(key); it != this -> _ids.end()) {
+
+		if ( this -> _entries[it -> second].source == source )
+			return false;
+
+		id = it -> second;
+
+	} else if ( !this -> _free.empty()) {
+
+		id = this -> _free.back();
+		this -> _free.pop_back();
+		this -> _ids[key] = id;
+
+	} else {
+
+		id = this -> _entries.size();
+		this -> _entries.emplace_back();
+		this -> _ids[key] = id;
+	}
+
+	ENTRY& e = this -> _entries[id];
+
+	e.key = key;
+	e.source = source;
+	e.compiled = expr::expression(source);
+	e.pretty = e.compiled.operator std::string();
+	e.generation = this -> _generation;
+	this -> bind(e);
+
+	this -> _compiled++;
+	return true;
+}
+
+void expr::compiled_property_map::remove(const size_t id) {
+
+	this -> _ids.erase(this -> _entries[id].key);
+	this -> _entries[id] = ENTRY();
+	this -> _free.push_back(id);
+	this -> _sorted = false;
+}
+
+// orders live entries so that entry setting a variable is before entries
+// reading it. Entries in cycles are ordered last by their ids
+void expr::compiled_property_map::sort() {
+
+	std::vector<size_t> degree(this -> _entries.size(), 0);
+	size_t live = 0;
+
+	this -> _readers.assign(this -> _schema.size(), {});
+	this -> _order.clear();
+
+	for ( size_t id = 0; id < this -> _entries.size(); id++ )
+		for ( size_t slot : this -> _entries[id].reads )
+			this -> _readers[slot].push_back(id);
+
+	for ( size_t id = 0; id < this -> _entries.size(); id++ ) {
+
+		const ENTRY& e = this -> _entries[id];
+
+		if ( e.key.empty())
+			continue;
+
+		live++;
+
+		if ( e.writes != expr::compiled_property_map::NONE )
+			for ( size_t reader : this -> _readers[e.writes] )
+				if ( reader != id )
+					degree[reader]++;
+	}
+
+	for ( size_t id = 0; id < this -> _entries.size(); id++ )
+		if ( !this -> _entries[id].key.empty() && degree[id] == 0 )
+			this -> _order.push_back(id);
+
+	for ( size_t i = 0; i < this -> _order.size(); i++ ) {
+
+		const ENTRY& e = this -> _entries[this -> _order[i]];
+
+		if ( e.writes != expr::compiled_property_map::NONE )
+			for ( size_t reader : this -> _readers[e.writes] )
+				if ( reader != this -> _order[i] && --degree[reader] == 0 )
+					this -> _order.push_back(reader);
+	}
+
+	if ( this -> _order.size() != live ) {
+
+		logger::warning["properties"] << live - this -> _order.size() << " properties depend on each other, " <<
+			"they are evaluated in order of their ids" << std::endl;
+
+		for ( size_t id = 0; id < this -> _entries.size(); id++ )
+			if ( !this -> _entries[id].key.empty() && degree[id] != 0 )
+				this -> _order.push_back(id);
+	}
+
+	this -> _sorted = true;
+}
+
+// entries reading slot are evaluated on next pass
+void expr::compiled_property_map::changed(const size_t slot) {
+
+	if ( slot < this -> _readers.size())
+		for ( size_t id : this -> _readers[slot] )
+			this -> _entries[id].pending = true;
+}
+
+void expr::compiled_property_map::fetch(const size_t slot) {
+
+	if ( this -> _vars != nullptr && !this -> _vars -> empty() && this -> _vars -> contains(this -> _schema[slot]))
+		this -> _slots[slot] = (*this -> _vars)[this -> _schema[slot]];
+	else this -> _slots[slot] = this -> _fallbacks[slot];
+}
+
+const size_t expr::compiled_property_map::load(const expr::PROPERTYMAP& m) {
+
+	std::unordered_set<std::string> keys;
+	size_t count = 0;
+
+	this -> _generation++;
+
+	for ( const auto& [key, source] : m ) {
+
+		std::string k = common::to_lower(std::as_const(key));
+
+		if ( this -> update(k, source))
+			count++;
+
+		keys.insert(std::move(k));
+	}
+
+	for ( size_t id = 0; id < this -> _entries.size(); id++ )
+		if ( !this -> _entries[id].key.empty() && !keys.contains(this -> _entries[id].key))
+			this -> remove(id);
+
+	return count;
+}
+
+void expr::compiled_property_map::set(const std::string& key, const std::string& source) {
+
+	this -> _generation++;
+	this -> update(common::to_lower(std::as_const(key)), source);
+}
+
+const bool expr::compiled_property_map::erase(const std::string& key) {
+
+	auto it = this -> _ids.find(common::to_lower(std::as_const(key)));
+
+	if ( it == this -> _ids.end())
+		return false;
+
+	this -> remove(it -> second);
+	return true;
+}
+
+void expr::compiled_property_map::clear() {
+
+	this -> _entries.clear();
+	this -> _ids.clear();
+	this -> _free.clear();
+	this -> _schema.clear();
+	this -> _slots_of.clear();
+	this -> _fallbacks.clear();
+	this -> _slots.clear();
+	this -> _order.clear();
+	this -> _readers.clear();
+	this -> _dirty.clear();
+	this -> _marked.clear();
+	this -> _loaded = 0;
+	this -> _sorted = false;
+}
+
+void expr::compiled_property_map::link(expr::FUNCTIONMAP *functions) {
+
+	this -> _funcs = functions;
+
+	for ( ENTRY& e : this -> _entries )
+		if ( !e.key.empty())
+			this -> bind(e);
+}
+
+const bool expr::compiled_property_map::contains(const std::string& key) const {
+
+	return this -> entry(key) != nullptr;
+}
+
+const size_t expr::compiled_property_map::size() const {
+
+	return this -> _ids.size();
+}
+
+const size_t expr::compiled_property_map::id(const std::string& key) const {
+
+	auto it = this -> _ids.find(common::to_lower(std::as_const(key)));
+	return it == this -> _ids.end() ? expr::compiled_property_map::NONE : it -> second;
+}
+
+const std::string expr::compiled_property_map::key(const size_t id) const {
+
+	return id < this -> _entries.size() ? this -> _entries[id].key : "";
+}
+
+const size_t expr::compiled_property_map::ids() const {
+
+	return this -> _entries.size();
+}
+
+const uint64_t expr::compiled_property_map::generation() const {
+
+	return this -> _generation;
+}
+
+const uint64_t expr::compiled_property_map::generation(const std::string& key) const {
+
+	const ENTRY *e = this -> entry(key);
+	return e == nullptr ? 0 : e -> generation;
+}
+
+const size_t expr::compiled_property_map::compiled() const {
+
+	return this -> _compiled;
+}
+
+expr::RESULT expr::compiled_property_map::get(const std::string& key, const std::variant<double, std::string, std::nullptr_t>& def) const {
+
+	const ENTRY *e = key.empty() ? nullptr : this -> entry(key);
+
+	if ( e == nullptr || e -> source.empty())
+		return expr::RESULT(def);
+
+	return expr::PROPERTY::value(e -> compiled, this -> _funcs, this -> _vars, def);
+}
+
+expr::RESULT expr::compiled_property_map::operator [](const std::string& key) const {
+
+	return this -> get(key, nullptr);
+}
+
+void expr::compiled_property_map::evaluate_all(std::vector<expr::RESULT>& results) {
+
+	this -> evaluate_all(expr::context::local(), results);
+}
+
+void expr::compiled_property_map::evaluate_all(expr::context& ctx, std::vector<expr::RESULT>& results) {
+
+	if ( !this -> _sorted )
+		this -> sort();
+
+	results.resize(this -> _entries.size());
+	this -> _slots.resize(this -> _schema.size());
+
+	for ( size_t i = 0; i < this -> _schema.size(); i++ )
+		this -> fetch(i);
+
+	for ( size_t id : this -> _free )
+		results[id].emplace<std::nullptr_t>(nullptr);
+
+	// clock of caller is left as it is, otherwise it is held while evaluating
+	bool held = ctx.clock_held();
+
+	if ( !held )
+		ctx.hold_clock();
+
+	// in order of dependencies like recompute(), so that property reading
+	// a variable sees value set by property before it
+	for ( size_t id : this -> _order ) {
+
+		const ENTRY& e = this -> _entries[id];
+		expr::RESULT& result = results[id];
+
+		if ( e.source.empty()) {
+			result.emplace<std::nullptr_t>(nullptr);
+			continue;
+		}
+
+		e.bound.run(ctx, nullptr, nullptr, this -> _slots, result);
+
+		// empty result is replaced with expression, like in PROPERTY::value
+		if ( std::string *s = std::get_if<std::string>(&result); s != nullptr && s -> empty())
+			*s = e.pretty;
+
+		if ( e.writes != expr::compiled_property_map::NONE && this -> _vars != nullptr )
+			(*this -> _vars)[this -> _schema[e.writes]] = this -> _slots[e.writes];
+	}
+
+	if ( !held )
+		ctx.release_clock();
+
+	// variables were set past dirty marks, recompute() starts again
+	this -> invalidate();
+}
+
+void expr::compiled_property_map::mark_dirty(const std::string& name) {
+
+	expr::SYMBOL id = expr::symbols::global().find(common::to_lower(std::as_const(name)));
+	auto it = id == expr::symbols::NONE ? this -> _slots_of.end() : this -> _slots_of.find(id);
+
+	if ( it == this -> _slots_of.end() || it -> second >= this -> _loaded )
+		return;
+
+	if ( this -> _marked.size() < this -> _schema.size())
+		this -> _marked.resize(this -> _schema.size(), false);
+
+	if ( !this -> _marked[it -> second] ) {
+		this -> _marked[it -> second] = true;
+		this -> _dirty.push_back(it -> second);
+	}
+}
+
+void expr::compiled_property_map::invalidate() {
+
+	this -> _loaded = 0;
+
+	for ( ENTRY& e : this -> _entries )
+		e.pending = true;
+}
+
+const std::vector<size_t>& expr::compiled_property_map::recompute(std::vector<expr::RESULT>& results) {
+
+	return this -> recompute(expr::context::local(), results);
+}
+
+const std::vector<size_t>& expr::compiled_property_map::recompute(expr::context& ctx, std::vector<expr::RESULT>& results) {
+
+	bool sorted = this -> _sorted;
+	size_t size = results.size();
+
+	this -> _changed.clear();
+
+	if ( !sorted )
+		this -> sort();
+
+	results.resize(this -> _entries.size());
+
+	for ( size_t id = size; id < this -> _entries.size(); id++ )
+		this -> _entries[id].pending = true;
+
+	// results of removed properties are cleared
+	if ( !sorted )
+		for ( size_t id : this -> _free )
+			if ( id < size && !results[id].is_null()) {
+				results[id].emplace<std::nullptr_t>(nullptr);
+				this -> _changed.push_back(id);
+			}
+
+	this -> _slots.resize(this -> _schema.size());
+
+	// slots added to schema are loaded, their readers are new or changed entries
+	for ( size_t slot = this -> _loaded; slot < this -> _schema.size(); slot++ )
+		this -> fetch(slot);
+
+	for ( size_t slot : this -> _dirty ) {
+
+		this -> _marked[slot] = false;
+
+		if ( slot >= this -> _loaded )
+			continue;
+
+		// same() compares numbers bitwise, change from 0 to -0 is
+		// passed on to readers too
+		this -> _previous = this -> _slots[slot];
+		this -> fetch(slot);
+
+		if ( !this -> _previous.same(this -> _slots[slot]))
+			this -> changed(slot);
+	}
+
+	this -> _dirty.clear();
+	this -> _loaded = this -> _schema.size();
+
+	bool held = ctx.clock_held();
+
+	if ( !held )
+		ctx.hold_clock();
+
+	for ( size_t id : this -> _order ) {
+
+		ENTRY& e = this -> _entries[id];
+
+		if ( !e.pending && !e.impure )
+			continue;
+
+		e.pending = false;
+
+		if ( e.writes != expr::compiled_property_map::NONE )
+			this -> _previous = this -> _slots[e.writes];
+
+		e.bound.run(ctx, nullptr, nullptr, this -> _slots, this -> _result);
+
+		if ( std::string *s = std::get_if<std::string>(&this -> _result); s != nullptr && s -> empty())
+			*s = e.pretty;
+
+		if ( !this -> _result.same(results[id])) {
+			std::swap(static_cast<expr::VARIABLE&>(results[id]), this -> _result);
+			this -> _changed.push_back(id);
+		}
+
+		if ( e.writes == expr::compiled_property_map::NONE )
+			continue;
+
+		bool set = !this -> _previous.same(this -> _slots[e.writes]);
+
+		if ( set )
+			this -> changed(e.writes);
+
+		if ( this -> _vars != nullptr && ( set || !this -> _vars -> contains(this -> _schema[e.writes])))
+			(*this -> _vars)[this -> _schema[e.writes]] = this -> _slots[e.writes];
+	}
+
+	if ( !held )
+		ctx.release_clock();
+
+	return this -> _changed;
+}
+
+const std::string expr::compiled_property_map::raw(const std::string& key) const {
+
+	const ENTRY *e = this -> entry(key);
+	return e == nullptr || e -> source.empty() ? "nullptr" : e -> source;
+}
+
+const std::string expr::compiled_property_map::pretty(const std::string& key) const {
+
+	const ENTRY *e = this -> entry(key);
+	return e == nullptr || e -> source.empty() ? "nullptr" : e -> pretty;
+}
+
+const expr::expression* expr::compiled_property_map::expression(const std::string& key) const {
+
+	const ENTRY *e = this -> entry(key);
+	return e == nullptr ? nullptr : &e -> compiled;
+}
@@ -0,0 +1,132 @@
+#include <cstring>
+#include "expr/context.hpp"
+
+// arena grows past its buffer to blocks of pool, which keeps them
+// when arena is released
+static const std::pmr::pool_options pool_options = {
+	.max_blocks_per_chunk = 0,
+	.largest_required_pool_block = 1 << 20
+};
+
+static thread_local expr::context *current_context = nullptr;
+
+expr::context::context() : _pool(pool_options), _arena(this -> _buffer.data(), this -> _buffer.size(), &this -> _pool) {
+}
+
+expr::value* expr::context::enter(const size_t size) {
+
+	if ( this -> _depth == 0 ) {
+		this -> _arena.release();
+		this -> _strings.clear();
+		this -> _strings.push_back(std::string_view());
+		this -> _previous = current_context;
+		current_context = this;
+
+		if ( !this -> _clock_held )
+			this -> _now_set = false;
+	}
+
+	if ( ++this -> _depth > this -> _args.size())
+		this -> _args.emplace_back();
+
+	return static_cast<expr::value*>(this -> _arena.allocate(sizeof(expr::value) * size, alignof(expr::value)));
+}
+
+void expr::context::leave() {
+
+	if ( --this -> _depth == 0 )
+		current_context = this -> _previous;
+}
+
+const uint32_t expr::context::view(std::string_view s) {
+
+	this -> _strings.push_back(s);
+	return (uint32_t)(this -> _strings.size() - 1);
+}
+
+const uint32_t expr::context::copy(std::string_view s1, std::string_view s2) {
+
+	char *p = static_cast<char*>(this -> _arena.allocate(s1.size() + s2.size() + 1, 1));
+
+	if ( !s1.empty()) std::memcpy(p, s1.data(), s1.size());
+	if ( !s2.empty()) std::memcpy(p + s1.size(), s2.data(), s2.size());
+	return this -> view(std::string_view(p, s1.size() + s2.size()));
+}
+
+expr::FUNCTION_ARGS& expr::context::args() {
+	return this -> _args[this -> _depth - 1];
+}
+
+const size_t expr::context::depth() const {
+	return this -> _depth;
+}
+
+std::pmr::memory_resource* expr::context::arena() {
+	return &this -> _arena;
+}
+
+const std::chrono::system_clock::time_point expr::context::now() {
+
+	if ( !this -> _now_set ) {
+		this -> _now = std::chrono::system_clock::now();
+		this -> _now_set = true;
+		this -> _tick++;
+	}
+
+	return this -> _now;
+}
+
+void expr::context::hold_clock() {
+
+	this -> _now = std::chrono::system_clock::now();
+	this -> _now_set = true;
+	this -> _clock_held = true;
+	this -> _tick++;
+}
+
+void expr::context::release_clock() {
+
+	this -> _clock_held = false;
+	this -> _now_set = false;
+}
+
+const bool expr::context::clock_held() const {
+	return this -> _clock_held;
+}
+
+const uint64_t expr::context::tick() {
+
+	this -> now();
+	return this -> _tick;
+}
+
+const std::tm& expr::context::local_time() {
+
+	if ( uint64_t tick = this -> tick(); this -> _tm_tick != tick ) {
+
+		std::time_t t = std::chrono::system_clock::to_time_t(this -> _now);
+
+		localtime_r(&t, &this -> _tm);
+		this -> _tm_tick = tick;
+	}
+
+	return this -> _tm;
+}
+
+expr::memo& expr::context::memo() {
+	return this -> _memo;
+}
+
+expr::context::ASSUMPTION& expr::context::assumption(const uint64_t expression) {
+	return this -> _assumptions[expression % this -> _assumptions.size()];
+}
+
+expr::context* expr::context::current() {
+	return current_context;
+}
+
+expr::context& expr::context::local() {
+
+	static thread_local expr::context c;
+	return c;
+}
@@ -1,910 +1,1315 @@
+#include <memory>
 #include <stdexcept>
 #include <utility>
+#include <functional>
+#include <algorithm>
 #include "common.hpp"
 #include "logger.hpp"
+#include "expr/ops.hpp"
+#include "expr/program.hpp"
+#include "expr/register_program.hpp"
 #include "expr/expression.hpp"
+#include "expr/parse_cache.hpp"
+#include "expr/batch.hpp"
+#include "expr/kernels.hpp"
 
-std::vector<std::vector<expr::TOKEN>> expr::expression::get_arg_tokens(const std::vector<expr::TOKEN>& tokens) {
+static double number(const expr::VARIABLE& v) {
 
-	std::vector<std::vector<expr::TOKEN>> args;
-	std::vector<expr::TOKEN> arg;
+	if ( const double *d = std::get_if<double>(&v))
+		return *d;
 
-	for ( const expr::TOKEN& token : tokens ) {
+	return v.to_double();
+}
 
-		if ( token == OP_COM ) {
-			args.push_back(arg);
-			arg.clear();
-		} else arg.push_back(token);
-	}
+// string value of operand, null is converted like null token is
+static std::string text(const expr::VARIABLE& v) {
 
-	if ( !arg.empty())
-		args.push_back(arg);
+	if ( const std::string *s = std::get_if<std::string>(&v))
+		return *s;
+	else if ( const double *d = std::get_if<double>(&v))
+		return common::to_string(*d);
 
-	return args;
+	return "null";
+}
+
+static double compare_strings(const expr::OP op, std::string_view s1, std::string_view s2) {
+
+	switch ( op ) {
+		case expr::OP_NEQ:
+		case expr::OP_SEQ: return expr::ops::SEQ(s1, s2);
+		case expr::OP_NNE:
+		case expr::OP_SNE: return expr::ops::SNE(s1, s2);
+		case expr::OP_NLT:
+		case expr::OP_SLT: return expr::ops::SLT(s1, s2);
+		case expr::OP_NLE:
+		case expr::OP_SLE: return expr::ops::SLE(s1, s2);
+		case expr::OP_NGT:
+		case expr::OP_SGT: return expr::ops::SGT(s1, s2);
+		case expr::OP_NGE:
+		case expr::OP_SGE: return expr::ops::SGE(s1, s2);
+		default: return 0;
+	}
 }
 
-const expr::VARIABLE expr::expression::get_variable_value(const std::string& name, expr::VARIABLEMAP *variables) {
+static double compare(const expr::OP op, const expr::VARIABLE& lhs, const expr::VARIABLE& rhs) {
 
-	if ( variables != nullptr && !name.empty() && !variables -> empty() && variables -> contains(name))
-		return (*variables)[name];
+	const std::string *s1 = std::get_if<std::string>(&lhs);
+	const std::string *s2 = std::get_if<std::string>(&rhs);
 
-	return (VARIABLE)nullptr;
+	if ( s1 != nullptr && s2 != nullptr )
+		return compare_strings(op, *s1, *s2);
+
+	return compare_strings(op, text(lhs), text(rhs));
 }
 
-expr::TOKEN expr::expression::tokenize_variable_value(const std::string& name, expr::VARIABLEMAP *variables) {
+// result of binary operator is stored to lhs
+static void apply(const expr::OP op, expr::VARIABLE& lhs, const expr::VARIABLE& rhs) {
 
-	expr::TOKEN tok;
+	switch ( op ) {
 
-	if ( variables != nullptr && !name.empty() && !variables -> empty() && variables -> contains(name)) {
+		/* basic math */
+		case expr::OP_ADD:
+			if ( rhs.is_string() && ( lhs.is_string() || lhs.is_number())) {
+				lhs.emplace<std::string>(expr::ops::CAT(text(lhs), text(rhs)));
+				return;
+			}
+			lhs.emplace<double>(expr::ops::ADD(number(lhs), number(rhs)));
+			return;
+		case expr::OP_SUB: lhs.emplace<double>(expr::ops::SUB(number(lhs), number(rhs))); return;
+		case expr::OP_CAT: lhs.emplace<std::string>(expr::ops::CAT(text(lhs), text(rhs))); return;
+		case expr::OP_MUL: lhs.emplace<double>(expr::ops::MUL(number(lhs), number(rhs))); return;
+		case expr::OP_DIV: lhs.emplace<double>(expr::ops::DIV(number(lhs), number(rhs))); return;
+		case expr::OP_MOD: lhs.emplace<double>(expr::ops::MOD(number(lhs), number(rhs))); return;
+		case expr::OP_POW: lhs.emplace<double>(expr::ops::POW(number(lhs), number(rhs))); return;
+
+		/* logical operators */
+		case expr::OP_OR2:
+		case expr::OP_OR: lhs.emplace<double>(expr::ops::OR(number(lhs), number(rhs))); return;
+		case expr::OP_AND2:
+		case expr::OP_AND: lhs.emplace<double>(expr::ops::AND(number(lhs), number(rhs))); return;
+
+		/* number comparators, strings are compared as strings */
+		case expr::OP_NEQ:
+		case expr::OP_NNE:
+		case expr::OP_NLT:
+		case expr::OP_NLE:
+		case expr::OP_NGT:
+		case expr::OP_NGE:
+
+			if ( lhs.is_string() || rhs.is_string()) {
+				lhs.emplace<double>(compare(op, lhs, rhs));
+				return;
+			}
 
-		expr::VARIABLE v = get_variable_value(name, variables);
+			switch ( op ) {
+				case expr::OP_NEQ: lhs.emplace<double>(expr::ops::NEQ(number(lhs), number(rhs))); return;
+				case expr::OP_NNE: lhs.emplace<double>(expr::ops::NNE(number(lhs), number(rhs))); return;
+				case expr::OP_NLT: lhs.emplace<double>(expr::ops::NLT(number(lhs), number(rhs))); return;
+				case expr::OP_NLE: lhs.emplace<double>(expr::ops::NLE(number(lhs), number(rhs))); return;
+				case expr::OP_NGT: lhs.emplace<double>(expr::ops::NGT(number(lhs), number(rhs))); return;
+				default: lhs.emplace<double>(expr::ops::NGE(number(lhs), number(rhs))); return;
+			}
 
-		if ( std::holds_alternative<std::string>(v))
-			tok = std::get<std::string>(v);
-		else if ( std::holds_alternative<double>(v))
-			tok = std::get<double>(v);
-	} else if ( !name.empty() && common::to_lower(std::as_const(name)) == "true" ) {
-		tok = (double)1;
-	} else if ( !name.empty() && common::to_lower(std::as_const(name)) == "false" ) {
-		tok = (double)0;
-	} else if ( !name.empty() && common::to_lower(std::as_const(name)) == "pi" ) {
-		tok = (double)M_PI;
-	} else if ( !name.empty() && common::to_lower(std::as_const(name)) == "pi_2" ) {
-		tok = (double)M_PI_2;
-	} else if ( !name.empty() && common::to_lower(std::as_const(name)) == "pi_4" ) {
-		tok = (double)M_PI_4;
-	} else if ( !name.empty() && common::to_lower(std::as_const(name)) == "e" ) {
-		tok = (double)M_E;
+		/* string comparators */
+		case expr::OP_SEQ:
+		case expr::OP_SNE:
+		case expr::OP_SLT:
+		case expr::OP_SLE:
+		case expr::OP_SGT:
+		case expr::OP_SGE:
+			lhs.emplace<double>(compare(op, lhs, rhs));
+			return;
+
+		default:
+			logger::error["evaluate"] << "unhandled unknown operator " << describe(op) << std::endl;
 	}
 
-	if ( tok == T_UNDEF ) tok = TOKEN::STRING("");
+	lhs.emplace<std::nullptr_t>(nullptr);
+}
 
-	return tok;
+// numeric operators, false when operator needs string operands
+static bool numeric(const expr::OP op, const double n1, const double n2, double& result) {
+
+	switch ( op ) {
+		case expr::OP_ADD: result = expr::ops::ADD(n1, n2); return true;
+		case expr::OP_SUB: result = expr::ops::SUB(n1, n2); return true;
+		case expr::OP_MUL: result = expr::ops::MUL(n1, n2); return true;
+		case expr::OP_DIV: result = expr::ops::DIV(n1, n2); return true;
+		case expr::OP_MOD: result = expr::ops::MOD(n1, n2); return true;
+		case expr::OP_POW: result = expr::ops::POW(n1, n2); return true;
+		case expr::OP_OR2:
+		case expr::OP_OR: result = expr::ops::OR(n1, n2); return true;
+		case expr::OP_AND2:
+		case expr::OP_AND: result = expr::ops::AND(n1, n2); return true;
+		case expr::OP_NEQ: result = expr::ops::NEQ(n1, n2); return true;
+		case expr::OP_NNE: result = expr::ops::NNE(n1, n2); return true;
+		case expr::OP_NLT: result = expr::ops::NLT(n1, n2); return true;
+		case expr::OP_NLE: result = expr::ops::NLE(n1, n2); return true;
+		case expr::OP_NGT: result = expr::ops::NGT(n1, n2); return true;
+		case expr::OP_NGE: result = expr::ops::NGE(n1, n2); return true;
+		default: return false;
+	}
 }
 
-std::vector<expr::TOKEN> expr::expression::eval_functions(
-	std::vector<expr::TOKEN>& tokens, expr::FUNCTIONMAP *functions, expr::VARIABLEMAP *variables) {
+// result of binary operator is stored to dst, dst may be lhs but not rhs
+static void apply(const expr::OP op, expr::VARIABLE& dst, const expr::VARIABLE& lhs, const expr::VARIABLE& rhs) {
 
-	// evaluate functions first
-	for ( size_t i = 0; i < tokens.size(); i++ ) {
+	const double *n1 = std::get_if<double>(&lhs);
+	const double *n2 = std::get_if<double>(&rhs);
+	double result;
 
-		TOKEN tok;
+	if ( n1 != nullptr && n2 != nullptr && numeric(op, *n1, *n2, result)) {
+		dst.emplace<double>(result);
+		return;
+	}
 
-		if ( tokens[i] != expr::T_FUNCTION ) continue;
+	if ( &dst != &lhs )
+		dst = lhs;
 
-		if ( tokens[i]._name.empty()) {
-			tokens[i] = tok; // T_UNDEF
-			return tokens;
-		}
+	apply(op, dst, rhs);
+}
 
-		if ( functions -> contains(tokens[i]._name) || expr::functions::builtin_functions.contains(tokens[i]._name)) {
+// value of variable, or fallback when it is not set, null values are empty strings
+static const expr::VARIABLE& load(const std::string& name, const expr::VARIABLE& fallback, expr::VARIABLEMAP *variables) {
 
-			std::vector<std::vector<expr::TOKEN>> args = get_arg_tokens(tokens[i]._args);
-			FUNCTION_ARGS f_args;
-			bool abort = false;
+	static const expr::VARIABLE empty_string(std::string(""));
 
-			for ( size_t a = 0; a < args.size(); a++ ) {
+	if ( variables != nullptr && !variables -> empty() && variables -> contains(name)) {
 
-				eval_f_arg:
+		const expr::VARIABLE& v = (*variables)[name];
+		return v.is_null() ? empty_string : v;
+	}
 
-				if ( abort ) {
-					abort = false;
-					continue;
-				}
+	return fallback;
+}
 
-				while ( !abort && args[a].size() > 1 ) {
-
-					try {
-						args[a] = eval(args[a], false, functions, variables);
-					} catch ( std::runtime_error& e ) {
-						logger::error["evaluate"] << "evaluation error for <" <<
-							describe(args[a]) << ">: " << e.what() << std::endl;
-						logger::warning["evaluate"] << "replacing with null" << std::endl;
-						args[a].clear();
-						args[a].push_back(expr::TOKEN::UNDEF());
-						abort = false; // note: this is intentional, we just replaced it
-					}
+static expr::FUNCTION* function(const std::string& name, expr::FUNCTIONMAP *functions) {
 
-					goto eval_f_arg;
-				}
+	if ( functions != nullptr && functions -> contains(name))
+		return &(*functions)[name];
+	else if ( expr::functions::builtin_functions.contains(name))
+		return &expr::functions::builtin_functions[name];
 
-				if ( !abort && args[a].size() == 1 && args[a].front() == expr::T_VARIABLE ) {
+	logger::warning["evaluate"] << "ignored unknown function " <<
+		common::to_lower(std::as_const(name)) << std::endl;
+	return nullptr;
+}
 
-					try {
-						args[a] = eval(args[a], false, functions, variables);
-					} catch ( std::runtime_error& e ) {
-						logger::error["evaluate"] << "evaluation error with variable <" <<
-							describe(args[a]) << ">: " << e.what() << std::endl;
-						abort = true;
-					}
+// function result is stored to dst, null result is an empty string. Native
+// functions get arguments from argv, others get them copied to args
+static void call(const std::string& name, expr::FUNCTION *f, expr::FUNCTION_ARGS_VIEW argv, expr::FUNCTION_ARGS& args, expr::VARIABLE& dst) {
 
-					goto eval_f_arg;
-				}
+	if ( f -> arity() != -1 && (size_t)f -> arity() != argv.size())
+		logger::warning["evaluate"] << "function " << common::to_lower(std::as_const(name)) << " expects " <<
+			f -> arity() << " arguments, " << argv.size() << " given" << std::endl;
 
-				if ( !abort && args[a].size() == 1 && args[a].front() == expr::T_FUNCTION ) {
+	if ( f -> is_numeric() && argv.size() == (size_t)f -> arity()) {
 
-					try {
-						args[a] = eval(args[a], false, functions, variables);
-					} catch ( std::runtime_error& e ) {
-						logger::error["evaluate"] << "evaluation error with function <" <<
-							describe(args[a]) << ">: " << e.what() << std::endl;
-						abort = true;
-					}
+		double n[4];
+		size_t i = 0;
 
-					goto eval_f_arg;
-				}
+		for ( ; i < argv.size(); i++ ) {
 
-				if ( !abort && args[a].size() == 1 && args[a].front() == expr::T_SUB && !args[a].front()._child.empty()) {
-					args[a] = args[a].front()._child;
-					goto eval_f_arg;
-				}
+			if ( const double *d = std::get_if<double>(&argv[i]))
+				n[i] = *d;
+			else break;
+		}
 
-				if ( args[a].size() == 1 ) {
+		if ( i == argv.size()) {
+			dst.emplace<double>(f -> numeric(n));
+			return;
+		}
+	}
 
-					VARIABLE arg;
+	if ( !f -> is_native())
+		args.assign(argv.begin(), argv.end());
 
-					if ( args[a][0].is_number())
-						arg = args[a][0].to_double();
-					else if ( args[a][0].is_string())
-						arg = args[a][0].to_string();
-					else arg = nullptr;
+	expr::VARIABLE result = f -> is_native() ? (*f)(argv) : (*f)(args);
 
-					f_args.push_back(arg);
+	if ( result.is_null())
+		dst.emplace<std::string>();
+	else dst.swap(result);
+}
 
-				} else f_args.push_back(nullptr);
+static expr::TOKEN aborted(const std::runtime_error& e, const std::string& set_variable, expr::VARIABLEMAP *variables, expr::VARIABLE *slot = nullptr) {
 
-				if ( abort )
-					logger::warning["evaluate"] << "evaluation problem, " <<
-						"abort caused by error in expression" << std::endl;
-			}
+	logger::error["evaluate"] << e.what() << std::endl;
+	logger::warning["evaluate"] << "evaluation was aborted because of errors";
 
-			VARIABLE arg = nullptr;
+	if ( !set_variable.empty() && ( variables != nullptr || slot != nullptr )) {
 
-			if ( functions -> contains(tokens[i]._name)) {
+		logger::warning << " and variable " << set_variable << " was set to nullptr";
 
-				arg = (*functions)[tokens[i]._name](f_args);
+		if ( slot != nullptr )
+			slot -> emplace<std::nullptr_t>(nullptr);
+		else (*variables)[set_variable] = nullptr;
+	}
 
-				if ( std::holds_alternative<std::string>(arg))
-					tok = std::get<std::string>(arg);
-				else if ( std::holds_alternative<double>(arg))
-					tok = std::get<double>(arg);
-				else tok = "";
+	logger::warning << std::endl;
+	return expr::TOKEN::UNDEF();
+}
 
-			} else if ( expr::functions::builtin_functions.contains(tokens[i]._name)) {
+// result of evaluation is stored to variable of assignment
+static void assign(const expr::VARIABLE& result, const std::string& set_variable, expr::VARIABLEMAP *variables, expr::VARIABLE *slot = nullptr) {
 
-				arg = expr::functions::builtin_functions[tokens[i]._name](f_args);
+	if ( !set_variable.empty() && ( variables != nullptr || slot != nullptr )) {
 
-				if ( std::holds_alternative<std::string>(arg))
-					tok = std::get<std::string>(arg);
-				else if ( std::holds_alternative<double>(arg))
-					tok = std::get<double>(arg);
-				else tok = "";
+		if ( result.is_null())
+			logger::verbose["evaluate"] << "ambiguos result of expr, variable " << set_variable <<
+				" was set to null" << std::endl;
 
-			} else tok = "";
+		if ( slot != nullptr )
+			*slot = result;
+		else if ( result.is_null())
+			(*variables)[set_variable] = nullptr;
+		else (*variables)[set_variable] = result;
+	}
+}
 
-			tokens[i] = tok;
-			return tokens;
+static expr::TOKEN finished(expr::VARIABLE result, const std::string& set_variable, expr::VARIABLEMAP *variables, expr::VARIABLE *slot = nullptr) {
 
-		} else {
+	assign(result, set_variable, variables, slot);
 
-			logger::warning["evaluate"] << "ignored unknown function " <<
-				common::to_lower(std::as_const(tokens[i]._name)) << std::endl;
-			tokens[i] = tok;
-			return tokens;
-		}
-	}
+	if ( const double *d = std::get_if<double>(&result))
+		return expr::TOKEN::NUMBER(*d);
+	else if ( std::string *s = std::get_if<std::string>(&result))
+		return expr::TOKEN::STRING(std::move(*s));
 
-	return tokens;
+	return expr::TOKEN::UNDEF();
 }
 
-std::vector<expr::TOKEN> expr::expression::eval_variables(
-	std::vector<expr::TOKEN>& tokens, expr::FUNCTIONMAP *functions, expr::VARIABLEMAP *variables) {
+/* values of stack program, strings of values are in context */
 
-	// evaluate variables
-	for ( size_t i = 0; i < tokens.size(); i++ ) {
+static expr::value to_value(expr::context& ctx, const expr::VARIABLE& v) {
 
-		if ( tokens[i] != expr::T_VARIABLE ) continue;
+	if ( const double *d = std::get_if<double>(&v))
+		return expr::value::NUMBER(*d);
+	else if ( const std::string *s = std::get_if<std::string>(&v))
+		return expr::value::STRING(ctx.copy(*s));
 
-		expr::TOKEN token = tokenize_variable_value(tokens[i]._name, variables);
-		tokens[i] = token;
-	}
-
-	return tokens;
+	return expr::value::NULLPTR();
 }
 
-std::vector<expr::TOKEN> expr::expression::eval_parentheses(std::vector<expr::TOKEN>& tokens,
-	expr::FUNCTIONMAP *functions, expr::VARIABLEMAP *variables) {
-
-	// evaluate parentheses
-	for ( size_t i = 0; i < tokens.size(); i++ ) {
+static expr::VARIABLE to_variable(const expr::context& ctx, const expr::value v) {
 
-		begin_loop:
+	if ( v.is_number())
+		return expr::VARIABLE(v.number());
+	else if ( v.is_string())
+		return expr::VARIABLE(std::string(ctx.string(v.string())));
 
-		if ( tokens[i] != expr::T_SUB )
-			continue;
+	return expr::VARIABLE();
+}
 
-		begin_evaluate:
+static double number(const expr::context& ctx, const expr::value v) {
 
-		if ( tokens[i] == expr::T_SUB && tokens[i]._child.size() > 1 ) {
+	return v.is_number() ? v.number() : to_variable(ctx, v).to_double();
+}
 
-			try {
-				tokens[i]._child = eval(tokens[i]._child, false, functions, variables);
-			} catch ( std::runtime_error& e ) {
-				logger::error["evaluate"] <<
-					"evaluation error inside parentheses <" <<
-					describe(tokens[i]._child) << ">: " << e.what() << std::endl;
-				logger::warning["evaluate"] << "replacing parentheses with null" << std::endl;
+// string value of operand, null is converted like null token is, buffer holds converted numbers
+static std::string_view text(const expr::context& ctx, const expr::value v, std::string& buffer) {
 
-				tokens[i]._child.clear();
-				tokens[i]._child.push_back(expr::TOKEN::UNDEF());
-			}
+	if ( v.is_string())
+		return ctx.string(v.string());
+	else if ( v.is_number())
+		return buffer = common::to_string(v.number());
 
-			goto begin_evaluate;
-		}
-
-		if ( tokens[i] == expr::T_SUB && tokens[i]._child.size() == 1 ) {
+	return "null";
+}
 
-			if ( tokens[i]._child[0] == expr::T_UNDEF ) {
+static double compare(const expr::context& ctx, const expr::OP op, const expr::value lhs, const expr::value rhs) {
 
-				logger::error["evaluate"] << "error while evaluating parentheses, result was null" << std::endl;
-				tokens.erase(i == 0 ? tokens.begin() : ( tokens.begin() + i ));
+	std::string b1, b2;
+	return compare_strings(op, text(ctx, lhs, b1), text(ctx, rhs, b2));
+}
 
-			} else tokens[i] = tokens[i]._child[0];
+// result of binary operator is stored to lhs
+static void apply(expr::context& ctx, const expr::OP op, expr::value& lhs, const expr::value rhs) {
 
-			i = 0;
-			goto begin_loop;
+	double result;
 
-		} else if ( tokens[i] == expr::T_SUB && tokens[i]._child.size() == 0 ) {
+	if ( lhs.is_number() && rhs.is_number() && numeric(op, lhs.number(), rhs.number(), result)) {
+		lhs = expr::value::NUMBER(result);
+		return;
+	}
 
-			logger::error["evaluate"] << "cannot evaluate value inside parentheses, it is considered as null" << std::endl;
+	std::string b1, b2;
 
-			tokens.erase(i == 0 ? tokens.begin() : ( tokens.begin() + i ));
+	switch ( op ) {
 
-			i = 0;
-			goto begin_loop;
-		}
+		/* basic math */
+		case expr::OP_ADD:
+			if ( rhs.is_string() && ( lhs.is_string() || lhs.is_number())) {
+				lhs = expr::value::STRING(ctx.copy(text(ctx, lhs, b1), text(ctx, rhs, b2)));
+				return;
+			}
+			lhs = expr::value::NUMBER(expr::ops::ADD(number(ctx, lhs), number(ctx, rhs)));
+			return;
+		case expr::OP_CAT: lhs = expr::value::STRING(ctx.copy(text(ctx, lhs, b1), text(ctx, rhs, b2))); return;
+		case expr::OP_SUB:
+		case expr::OP_MUL:
+		case expr::OP_DIV:
+		case expr::OP_MOD:
+		case expr::OP_POW:
+		case expr::OP_OR2:
+		case expr::OP_OR:
+		case expr::OP_AND2:
+		case expr::OP_AND:
+			numeric(op, number(ctx, lhs), number(ctx, rhs), result);
+			lhs = expr::value::NUMBER(result);
+			return;
+
+		/* number comparators, strings are compared as strings */
+		case expr::OP_NEQ:
+		case expr::OP_NNE:
+		case expr::OP_NLT:
+		case expr::OP_NLE:
+		case expr::OP_NGT:
+		case expr::OP_NGE:
+
+			if ( lhs.is_string() || rhs.is_string())
+				lhs = expr::value::NUMBER(compare(ctx, op, lhs, rhs));
+			else {
+				numeric(op, number(ctx, lhs), number(ctx, rhs), result);
+				lhs = expr::value::NUMBER(result);
+			}
+			return;
+
+		/* string comparators */
+		case expr::OP_SEQ:
+		case expr::OP_SNE:
+		case expr::OP_SLT:
+		case expr::OP_SLE:
+		case expr::OP_SGT:
+		case expr::OP_SGE:
+			lhs = expr::value::NUMBER(compare(ctx, op, lhs, rhs));
+			return;
+
+		default:
+			logger::error["evaluate"] << "unhandled unknown operator " << describe(op) << std::endl;
 	}
 
-	return tokens;
+	lhs = expr::value::NULLPTR();
 }
 
-std::vector<expr::TOKEN> expr::expression::eval_conditionals(
-	std::vector<expr::TOKEN>&tokens, expr::FUNCTIONMAP *functions, expr::VARIABLEMAP *variables) {
+// constant of program on stack, strings of constants are indexes to strings of program
+static expr::value from_constant(expr::context& ctx, const std::vector<std::string>& strings, const expr::value c) {
 
-	// pre-process conditionals
-	for ( size_t i = 0; i < tokens.size(); i++ ) {
+	return c.is_string() ? expr::value::STRING(ctx.view(strings[c.string()])) : c;
+}
 
-		if ( tokens[i] != expr::T_CONDITIONAL )
-			continue;
+// value of variable, or fallback constant when it is not set, null values are empty strings
+static expr::value load(expr::context& ctx, const std::vector<std::string>& strings, const std::string& name, const expr::value fallback, expr::VARIABLEMAP *variables) {
 
-		begin_evaluate:
+	if ( variables != nullptr && !variables -> empty() && variables -> contains(name)) {
 
-		if ( tokens[i]._cond1.size() > 1 ) {
+		const expr::VARIABLE& v = (*variables)[name];
+		return v.is_null() ? expr::value::STRING(0) : to_value(ctx, v);
+	}
 
-			try {
-				tokens[i]._cond1 = eval(tokens[i]._cond1, false, functions, variables);
-			} catch ( std::runtime_error& e ) {
+	return from_constant(ctx, strings, fallback);
+}
 
-				logger::error["evaluate"] <<
-					"evaluation error inside condition's true result <" <<
-					describe(tokens[i]._cond1) << ">: " << e.what() << std::endl;
-				logger::warning["evaluate"] << "replacing true condition with null" << std::endl;
+static expr::value load(expr::context& ctx, const std::vector<std::string>& strings, const expr::SYMBOL name, const expr::value fallback, const expr::variable_store& variables) {
 
-				tokens[i]._cond1.clear();
-				tokens[i]._cond1.push_back(expr::TOKEN::UNDEF());
-			}
+	if ( size_t slot = variables.find(name); variables.is_set(slot)) {
 
-			goto begin_evaluate;
-		}
+		const expr::VARIABLE& v = variables.get(slot);
+		return v.is_null() ? expr::value::STRING(0) : to_value(ctx, v);
+	}
 
-		if ( tokens[i]._cond1.size() == 1 && tokens[i]._cond1[0] == expr::T_UNDEF )
-			logger::verbose["evaluate"] << "warning, while pre-processing conditional, true result is undefined result" << std::endl;
-		else if ( tokens[i]._cond1.size() == 0 ) {
-			logger::error["evaluate"] << "conditional true result evaluated to null" << std::endl;
-			tokens[i]._cond1.push_back(TOKEN::UNDEF());
-		}
+	return from_constant(ctx, strings, fallback);
+}
 
-		begin_evaluate2:
+// result of function, null result is an empty string. Numeric functions are
+// called with numbers, others get arguments converted to VARIABLEs in args
+static expr::value call(expr::context& ctx, const std::string& name, expr::FUNCTION *f, const expr::value *argv, const size_t argc, expr::FUNCTION_ARGS& args) {
 
-		if ( tokens[i]._cond2.size() > 1 ) {
+	if ( f -> arity() != -1 && (size_t)f -> arity() != argc )
+		logger::warning["evaluate"] << "function " << common::to_lower(std::as_const(name)) << " expects " <<
+			f -> arity() << " arguments, " << argc << " given" << std::endl;
 
-			try {
-				tokens[i]._cond2 = eval(tokens[i]._cond2, false, functions, variables);
-			} catch ( std::runtime_error& e ) {
-				logger::error["evaluate"] <<
-					"evaluation error inside condition's false result <" <<
-					describe(tokens[i]._cond2) << ">: " << e.what() << std::endl;
-				logger::warning["evaluate"] << "replacing false condition with null" << std::endl;
+	if ( f -> is_numeric() && argc == (size_t)f -> arity()) {
 
-				tokens[i]._cond2.clear();
-				tokens[i]._cond2.push_back(expr::TOKEN::UNDEF());
-			}
-			goto begin_evaluate2;
-		}
+		double n[4];
+		size_t i = 0;
 
-		if ( tokens[i]._cond2.size() == 1 && tokens[i]._cond2[0] == expr::T_UNDEF )
-			logger::verbose["evaluate"] << "warning, while pre-processing conditional, false result is undefined result" << std::endl;
-		else if ( tokens[i]._cond2.size() == 0 ) {
-			logger::error["evaluate"] << "conditional false result evaluated to null" << std::endl;
-			tokens[i]._cond1.push_back(expr::TOKEN::UNDEF());
-		}
+		for ( ; i < argc && argv[i].is_number(); i++ )
+			n[i] = argv[i].number();
 
-		return tokens;
+		if ( i == argc )
+			return expr::value::NUMBER(f -> numeric(n));
 	}
 
-	return tokens;
+	args.clear();
+
+	for ( size_t i = 0; i < argc; i++ )
+		args.push_back(to_variable(ctx, argv[i]));
+
+	expr::VARIABLE result = f -> is_native() ? (*f)(expr::FUNCTION_ARGS_VIEW(args)) : (*f)(args);
+	return result.is_null() ? expr::value::STRING(0) : to_value(ctx, result);
 }
 
-void expr::expression::process_rhs_token(std::vector<expr::TOKEN>& tokens, size_t index1, size_t index2) {
+// numeric functions are cheaper to call than to look up, and every evaluation
+// has its own tick unless clock is held
+static bool memoizable(expr::context& ctx, const expr::FUNCTION *f, const size_t argc) {
 
-	if ( tokens.size() > index2 &&
-		( tokens[index1] == expr::OP_NOT || tokens[index1] == expr::OP_NNOT ) &&
-		( tokens[index2] == expr::T_NUMBER || tokens[index2] == expr::T_STRING )) {
+	if ( argc > expr::memo::MAX_ARGS )
+		return false;
+	else if ( f -> purity() == expr::F_PURE )
+		return !f -> is_numeric();
+	else if ( f -> purity() == expr::F_PER_TICK )
+		return ctx.clock_held();
 
-		if ( tokens[index1] == expr::OP_NOT )
-			tokens[index2] = expr::TOKEN::NOT(tokens[index2].to_double());
-		else tokens[index2] = expr::TOKEN::NNOT(tokens[index2].to_double());
+	return false;
+}
 
-		tokens.erase(tokens.begin() + index1);
+// result of pure or per tick call from memo of context, function is called
+// when it was not called with same arguments from same call site
+static expr::value memoized(expr::context& ctx, const uint64_t site, const std::string& name, expr::FUNCTION *f, const expr::value *argv, const size_t argc, expr::FUNCTION_ARGS& args) {
 
-		return;
-	}
+	uint64_t tick = f -> purity() == expr::F_PER_TICK ? ctx.tick() : 0;
 
-	bool r_negate = false;
+	if ( const expr::VARIABLE *v = ctx.memo().find(ctx, site, f, tick, argv, argc))
+		return to_value(ctx, *v);
 
-	// handle multiple negative signs in row..
-	if ( tokens.size() > index2 && tokens[index1] == expr::OP_SUB && tokens[index2] == expr::OP_SUB ) {
+	expr::value result = call(ctx, name, f, argv, argc, args);
+	ctx.memo().store(ctx, site, f, tick, argv, argc, result);
+	return result;
+}
 
-		while ( tokens.size() > index2 && tokens[index1] == expr::OP_SUB && tokens[index2] == expr::OP_SUB ) {
-			if ( tokens[index2] == expr::OP_SUB ) r_negate = !r_negate;
-			tokens.erase(tokens.begin() + index1);
-		}
+// value stack of program, returned to context when evaluation ends
+struct evaluation_frame {
 
-	}
+	expr::context& ctx;
+	expr::value *stack;
 
-	if ( tokens.size() > index2 && tokens[index1] == expr::OP_SUB &&
-		( tokens[index2] == expr::T_NUMBER || tokens[index2] == expr::T_STRING )) {
+	evaluation_frame(expr::context& ctx, const size_t size) : ctx(ctx), stack(ctx.enter(size)) {}
+	~evaluation_frame() { this -> ctx.leave(); }
+};
 
-		tokens[index2] = expr::TOKEN::SGN(r_negate ? -(tokens[index2].to_double()) : tokens[index2].to_double());
-		tokens.erase(tokens.begin() + index1);
-	}
+expr::TOKEN expr::program::run(expr::FUNCTIONMAP *functions, expr::VARIABLEMAP *variables, std::span<expr::VARIABLE> slots) const {
+
+	return this -> run(expr::context::local(), functions, variables, slots);
 }
 
-std::vector<expr::TOKEN> expr::expression::eval(
-	std::vector<expr::TOKEN>& tokens, bool f_args, expr::FUNCTIONMAP *functions, expr::VARIABLEMAP *variables) {
+expr::TOKEN expr::program::run(expr::context& ctx, expr::FUNCTIONMAP *functions, expr::VARIABLEMAP *variables, std::span<expr::VARIABLE> slots) const {
 
-	expr::TOKEN token;
+	if ( this -> _code.empty())
+		return expr::TOKEN::UNDEF();
 
-	tokens = eval_variables(tokens, functions, variables);
-	tokens = eval_functions(tokens, functions, variables);
-	tokens = eval_parentheses(tokens, functions, variables);
-	tokens = eval_conditionals(tokens, functions, variables);
+	VARIABLE *set_slot = this -> _set_slot >= 0 && (size_t)this -> _set_slot < slots.size() ?
+		&slots[this -> _set_slot] : nullptr;
 
-	// evaluate base ops
+	try {
+		value result = this -> execute(ctx, functions, variables, slots);
+		return finished(to_variable(ctx, result), this -> _set_variable, variables, set_slot);
+	} catch ( std::runtime_error& e ) {
+		return aborted(e, this -> _set_variable, variables, set_slot);
+	}
+}
 
-	if ( tokens[0] == expr::T_OPERATOR ) {
+expr::TOKEN expr::program::run(expr::context& ctx, expr::FUNCTIONMAP *functions, expr::variable_store& variables) const {
 
-		if ( tokens[0] == expr::OP_SUB || tokens[0] == expr::OP_NOT || tokens[0] == expr::OP_NNOT ) { // O_SGN
-			if ( tokens.size() < 2 ) {
-				logger::warning["evaluate"] <<
-					"single operator(" << describe(tokens[0]._op) << ") without " <<
-					"left and right side value always returns 0" << std::endl;
-				tokens[0] = expr::TOKEN::NUMBER(0);
-				return tokens;
-			}
+	if ( this -> _code.empty())
+		return expr::TOKEN::UNDEF();
 
-			process_rhs_token(tokens, 0, 1);
+	// set variable is written to store after evaluation, store bumps its version if it changed
+	VARIABLE set;
+	VARIABLE *set_slot = this -> _set_variable.empty() ? nullptr : &set;
+	TOKEN token;
 
-			if ( tokens.size() < 2 || ( tokens[0] != expr::T_OPERATOR && tokens[1] != expr::T_OPERATOR ))
-				return tokens;
-		}
+	try {
+		value result = this -> execute(ctx, functions, nullptr, {}, &variables);
+		token = finished(to_variable(ctx, result), this -> _set_variable, nullptr, set_slot);
+	} catch ( std::runtime_error& e ) {
+		token = aborted(e, this -> _set_variable, nullptr, set_slot);
+	}
 
-		if ( !( tokens.size() > 1 && tokens[1] == expr::OP_SUB &&
-			( tokens[0] == expr::OP_NOT || tokens[0] == expr::OP_NNOT ))) {
+	if ( set_slot != nullptr )
+		variables.set(variables.slot(this -> _set_symbol), set);
 
-			logger::error["evaluate"] << "left side value missing from expression" << std::endl;
-			tokens.erase(tokens.begin());
-			return tokens;
-		}
-	}
+	return token;
+}
 
-	/* evaluate conditions */
+void expr::program::run(expr::context& ctx, expr::FUNCTIONMAP *functions, expr::VARIABLEMAP *variables, std::span<expr::VARIABLE> slots, expr::VARIABLE& result) const {
 
-	if ( tokens[0] == expr::T_CONDITIONAL ) {
+	VARIABLE *set_slot = this -> _set_slot >= 0 && (size_t)this -> _set_slot < slots.size() ?
+		&slots[this -> _set_slot] : nullptr;
 
-		logger::error["evaluate"] << "conditional expression without condition, ignoring" << std::endl;
-		tokens.erase(tokens.begin());
-		return tokens;
+	if ( this -> _code.empty()) {
+		result.emplace<std::nullptr_t>(nullptr);
+		return;
 	}
 
-	if ( tokens.size() > 1 && tokens[1] == expr::T_CONDITIONAL ) {
+	try {
+		value v = this -> execute(ctx, functions, variables, slots);
 
-		if ( tokens[0].to_double() == 0 )
-			tokens[0] = tokens[1]._cond2[0];
-		else
-			tokens[0] = tokens[1]._cond1[0];
+		if ( v.is_number())
+			result.emplace<double>(v.number());
+		else if ( v.is_null())
+			result.emplace<std::nullptr_t>(nullptr);
+		else if ( std::string *s = std::get_if<std::string>(&result))
+			s -> assign(ctx.string(v.string()));
+		else result.emplace<std::string>(ctx.string(v.string()));
 
-		tokens.erase(tokens.begin() + 1);
-		return tokens;
+		assign(result, this -> _set_variable, variables, set_slot);
+
+	} catch ( std::runtime_error& e ) {
+		aborted(e, this -> _set_variable, variables, set_slot);
+		result.emplace<std::nullptr_t>(nullptr);
 	}
+}
 
-	/* evaluate rest of ops */
-
-	if ( tokens.size() > 1 && tokens[1] == expr::T_OPERATOR ) {
-
-		switch ( tokens[1]._op ) {
-
-			/* basic math */
-			case expr::OP_ADD:
-				if ( tokens.size() > 2 ) {
-					process_rhs_token(tokens, 2, 3);
-					if ( tokens[0].is_string() && tokens[2].is_string())
-						tokens[2] = expr::TOKEN::CAT(tokens[0].to_string(), tokens[2].to_string());
-					else if ( tokens[0].is_number() && tokens[2].is_string())
-						tokens[2] = expr::TOKEN::CAT(tokens[0].to_string(), tokens[2].to_string());
-					else
-						tokens[2] = expr::TOKEN::ADD(tokens[0].to_double(), tokens[2].to_double());
-					tokens.erase(tokens.begin(), tokens.begin() + 2);
-				} else {
-					logger::error["evaluate"] << "operator ADD(+) with missing right side value" << std::endl;
-					tokens.erase(tokens.begin() + 1);
-				}
-				break;
+// value of program, it stays valid in context until next outermost evaluation begins
+expr::value expr::program::execute(expr::context& ctx, expr::FUNCTIONMAP *functions, expr::VARIABLEMAP *variables, std::span<expr::VARIABLE> slots, const expr::variable_store *store) const {
 
-			case OP_SUB:
+	const INSTRUCTION *code = this -> _code.data();
+	const size_t size = this -> _code.size();
+	const symbols& names = symbols::global();
+	evaluation_frame f(ctx, this -> _max_depth);
+	value *stack = f.stack;
+	FUNCTION_ARGS& args = ctx.args();
+	size_t sp = 0;
 
-				if ( tokens.size() > 2 ) {
+	for ( size_t pc = 0; pc < size; pc++ ) {
 
-					if ( tokens[0] == expr::OP_NOT || tokens[0] == expr::OP_NNOT ) {
+		const INSTRUCTION& in = code[pc];
 
-						if ( tokens[2] == expr::T_NUMBER || tokens[2] == expr::T_STRING ) {
+		switch ( in.code ) {
 
-							tokens[2] = expr::TOKEN::NUMBER(-tokens[2].to_double());
-							tokens.erase(tokens.begin() + 1);
-						}
+			case expr::I_CONST:
+				stack[sp++] = from_constant(ctx, this -> _strings, this -> _constants[in.a]);
+				break;
 
-						break;
-					}
+			case expr::I_LOAD:
+				stack[sp++] = store != nullptr ? load(ctx, this -> _strings, this -> _names[in.a], this -> _constants[in.b], *store) :
+					load(ctx, this -> _strings, names.string(this -> _names[in.a]), this -> _constants[in.b], variables);
+				break;
 
-					process_rhs_token(tokens, 2, 3);
-					tokens[2] = expr::TOKEN::SUB(tokens[0].to_double(), tokens[2].to_double());
-					tokens.erase(tokens.begin(), tokens.begin() + 2);
-				} else {
-					logger::error["evaluate"] << "operator SUB(-) with missing right side value" << std::endl;
-					tokens.erase(tokens.begin() + 1);
-				}
+			case expr::I_SLOT:
+				stack[sp++] = slots[in.a].is_null() ? value::STRING(0) : to_value(ctx, slots[in.a]);
 				break;
 
-			case OP_CAT:
+			case expr::I_CALL:
+			case expr::I_LINKED: {
+					expr::FUNCTION *f = in.code == expr::I_LINKED ? this -> _handles[in.a] :
+						function(names.string(this -> _names[in.a]), functions);
 
-				if ( tokens.size() > 2 ) {
-					process_rhs_token(tokens, 2, 3);
-					tokens[2] = expr::TOKEN::CAT(tokens[0].to_string(), tokens[2].to_string());
-					tokens.erase(tokens.begin(), tokens.begin() + 2);
-				} else {
-					logger::error["evaluate"] << "operator CAT(.) with missing right side value" << std::endl;
-					tokens.erase(tokens.begin() + 1);
-				}
-				break;
+					sp -= in.b;
 
-			case OP_MUL:
+					if ( f == nullptr )
+						stack[sp] = value::NULLPTR();
+					else if ( memoizable(ctx, f, in.b))
+						stack[sp] = memoized(ctx, this -> _id << 24 | pc, names.string(this -> _names[in.a]), f, stack + sp, in.b, args);
+					else stack[sp] = call(ctx, names.string(this -> _names[in.a]), f, stack + sp, in.b, args);
 
-				if ( tokens.size() > 2 ) {
-					process_rhs_token(tokens, 2, 3);
-					tokens[2] = expr::TOKEN::MUL(tokens[0].to_double(), tokens[2].to_double());
-					tokens.erase(tokens.begin(), tokens.begin() + 2);
-				} else {
-					logger::error["evaluate"] << "operator MUL(*) with missing right side value" << std::endl;
-					tokens.erase(tokens.begin() + 1);
+					sp++;
 				}
 				break;
 
-			case OP_DIV:
+			case expr::I_UNARY: {
+					value& v = stack[sp - 1];
 
-				if ( tokens.size() > 2 ) {
-					process_rhs_token(tokens, 2, 3);
-					tokens[2] = expr::TOKEN::DIV(tokens[0].to_double(), tokens[2].to_double());
-					tokens.erase(tokens.begin(), tokens.begin() + 2);
-				} else {
-					logger::error["evaluate"] << "operator DIV(/) with missing right side value" << std::endl;
-					tokens.erase(tokens.begin() + 1);
+					switch ( in.op ) {
+						case expr::OP_SUB: v = value::NUMBER(expr::ops::SGN(number(ctx, v))); break;
+						case expr::OP_NOT: v = value::NUMBER(expr::ops::NOT(number(ctx, v))); break;
+						case expr::OP_NNOT: v = value::NUMBER(expr::ops::NNOT(number(ctx, v))); break;
+						default: break;
+					}
 				}
 				break;
 
-			case OP_MOD:
-
-				if ( tokens.size() > 2 ) {
-					process_rhs_token(tokens, 2, 3);
-					tokens[2] = expr::TOKEN::MOD(tokens[0].to_double(), tokens[2].to_double());
-					tokens.erase(tokens.begin(), tokens.begin() + 2);
-				} else {
-					logger::error["evaluate"] << "operator MOD(%) with missing right side value" << std::endl;
-					tokens.erase(tokens.begin() + 1);
-				}
+			case expr::I_BINARY:
+				apply(ctx, in.op, stack[sp - 2], stack[sp - 1]);
+				sp--;
 				break;
 
-			case OP_POW:
+			case expr::I_JUMP:
+				pc = in.a - 1;
+				break;
 
-				if ( tokens.size() > 2 ) {
-					process_rhs_token(tokens, 2, 3);
-					tokens[2] = expr::TOKEN::POW(tokens[0].to_double(), tokens[2].to_double());
-					tokens.erase(tokens.begin(), tokens.begin() + 2);
-				} else {
-					logger::error["evaluate"] << "operator POW(^)with missing right side value" << std::endl;
-					tokens.erase(tokens.begin() + 1);
-				}
+			case expr::I_JUMP_FALSE:
+				if ( number(ctx, stack[--sp]) == 0 )
+					pc = in.a - 1;
 				break;
 
-			/* logical operators */
-			case OP_OR2:
+			case expr::I_AND:
+				if ( number(ctx, stack[sp - 1]) == 0 ) {
+					stack[sp - 1] = value::NUMBER(0);
+					pc = in.a - 1;
+				} else sp--;
+				break;
 
-				if ( tokens.size() > 2 ) {
-					process_rhs_token(tokens, 2, 3);
-					tokens[2] = expr::TOKEN::OR2(tokens[0].to_double(), tokens[2].to_double());
-					tokens.erase(tokens.begin(), tokens.begin() + 2);
-				} else {
-					logger::error["evaluate"] << "operator OR(|) with missing right side value" << std::endl;
-					tokens.erase(tokens.begin() + 1);
-				}
+			case expr::I_OR:
+				if ( number(ctx, stack[sp - 1]) != 0 ) {
+					stack[sp - 1] = value::NUMBER(1);
+					pc = in.a - 1;
+				} else sp--;
 				break;
+		}
+	}
 
-			case OP_OR: // same as OP_OR2, but symbol is & instead of &&
+	return stack[0];
+}
 
-				if ( tokens.size() > 2 ) {
-					process_rhs_token(tokens, 2, 3);
-					tokens[2] = expr::TOKEN::OR(tokens[0].to_double(), tokens[2].to_double());
-					tokens.erase(tokens.begin(), tokens.begin() + 2);
-				} else {
-					logger::error["evaluate"] << "operator OR(|) with missing right side value" << std::endl;
-					tokens.erase(tokens.begin() + 1);
-				}
-				break;
+expr::TOKEN expr::expression::evaluate(expr::FUNCTIONMAP *functions, expr::VARIABLEMAP *variables) const {
 
+	return this -> evaluate(expr::context::local(), functions, variables);
+}
 
-			case OP_AND2:
+expr::TOKEN expr::expression::evaluate(expr::context& ctx, expr::FUNCTIONMAP *functions, expr::VARIABLEMAP *variables) const {
 
-				if ( tokens.size() > 2 ) {
-					process_rhs_token(tokens, 2, 3);
-					tokens[2] = expr::TOKEN::AND2(tokens[0].to_double(), tokens[2].to_double());
-					tokens.erase(tokens.begin(), tokens.begin() + 2);
-				} else {
-					logger::error["evaluate"] << "operator AND(&) with missing right side value" << std::endl;
-					tokens.erase(tokens.begin() + 1);
-				}
-				break;
+	if ( !this -> assumptions_hold(ctx, functions, variables))
+		return this -> _unfolded.run(ctx, functions, variables);
+	else if ( this -> _constant )
+		return this -> _value.is_string() ? expr::TOKEN::STRING(this -> _value.raw_string()) :
+			expr::TOKEN::NUMBER(this -> _value.raw_double());
 
-			case OP_AND:
+	return this -> _program.run(ctx, functions, variables);
+}
 
-				if ( tokens.size() > 2 ) {
-					process_rhs_token(tokens, 2, 3);
-					tokens[2] = expr::TOKEN::AND(tokens[0].to_double(), tokens[2].to_double());
-					tokens.erase(tokens.begin(), tokens.begin() + 2);
-				} else {
-					logger::error["evaluate"] << "operator AND(&) with missing right side value" << std::endl;
-					tokens.erase(tokens.begin() + 1);
-				}
-				break;
+expr::TOKEN expr::expression::evaluate(expr::FUNCTIONMAP *functions, expr::variable_store& variables) const {
 
-			case OP_NOT: /* Operatos NOT and NNOT are handled in */
-				break;
-			case OP_NNOT: /* process_rhs_token, we should never be here */
-				break;
+	return this -> evaluate(expr::context::local(), functions, variables);
+}
 
-			/* number comparators */
-			case OP_NEQ:
-
-				if ( tokens.size() > 2 ) {
-					process_rhs_token(tokens, 2, 3);
-					if ( tokens[0].is_string() || tokens[2].is_string())
-						tokens[2] = expr::TOKEN::SEQ(tokens[0].to_string(), tokens[2].to_string());
-					else
-						tokens[2] = expr::TOKEN::NEQ(tokens[0].to_double(), tokens[2].to_double());
-					tokens.erase(tokens.begin(), tokens.begin() + 2);
-				} else {
-					logger::error["evaluate"] << "operator NEQ(==) with missing right side value" << std::endl;
-					tokens.erase(tokens.begin() + 1);
-				}
-				break;
+expr::TOKEN expr::expression::evaluate(expr::context& ctx, expr::FUNCTIONMAP *functions, expr::variable_store& variables) const {
 
-			case OP_NNE:
-
-				if ( tokens.size() > 2 ) {
-					process_rhs_token(tokens, 2, 3);
-					if ( tokens[0].is_string() || tokens[2].is_string())
-						tokens[2] = expr::TOKEN::SNE(tokens[0].to_string(), tokens[2].to_string());
-					else
-						tokens[2] = expr::TOKEN::NNE(tokens[0].to_double(), tokens[2].to_double());
-					tokens.erase(tokens.begin(), tokens.begin() + 2);
-				} else {
-					logger::error["evaluate"] << "operator NNE(!=) with missing right side value" << std::endl;
-					tokens.erase(tokens.begin() + 1);
-				}
-				break;
+	if ( !this -> assumptions_hold(ctx, functions, variables))
+		return this -> _unfolded.run(ctx, functions, variables);
+	else if ( this -> _constant )
+		return this -> _value.is_string() ? expr::TOKEN::STRING(this -> _value.raw_string()) :
+			expr::TOKEN::NUMBER(this -> _value.raw_double());
 
-			case OP_NLT:
-
-				if ( tokens.size() > 2 ) {
-					process_rhs_token(tokens, 2, 3);
-					if ( tokens[0].is_string() || tokens[2].is_string())
-						tokens[2] = expr::TOKEN::SLT(tokens[0].to_string(), tokens[2].to_string());
-					else
-						tokens[2] = expr::TOKEN::NLT(tokens[0].to_double(), tokens[2].to_double());
-					tokens.erase(tokens.begin(), tokens.begin() + 2);
-				} else {
-					logger::error["evaluate"] << "operator NLT(<) with missing right side value" << std::endl;
-					tokens.erase(tokens.begin() + 1);
-				}
-				break;
+	return this -> _program.run(ctx, functions, variables);
+}
 
-			case OP_NLE:
-
-				if ( tokens.size() > 2 ) {
-					process_rhs_token(tokens, 2, 3);
-					if ( tokens[0].is_string() || tokens[2].is_string())
-						tokens[2] = expr::TOKEN::SLE(tokens[0].to_string(), tokens[2].to_string());
-					else
-						tokens[2] = expr::TOKEN::NLE(tokens[0].to_double(), tokens[2].to_double());
-					tokens.erase(tokens.begin(), tokens.begin() + 2);
-				} else {
-					logger::error["evaluate"] << "operator NLE(<=) with missing right side value" << std::endl;
-					tokens.erase(tokens.begin() + 1);
-				}
+expr::TOKEN expr::expression::evaluate(const std::string& s, expr::FUNCTIONMAP *functions, expr::VARIABLEMAP *variables) {
+
+	if ( this -> _raw != s )
+		*this = *expr::parse_cache::global().get(s);
+
+	return this -> evaluate(functions, variables);
+}
+
+/* batch of rows, evaluated a chunk at a time */
+
+// each row of selection
+template <typename F>
+static inline void each(const expr::SELECTION& s, F f) {
+
+	if ( s.dense )
+		for ( size_t i = 0; i < s.count; i++ ) f(i);
+	else for ( size_t i = 0; i < s.count; i++ ) f((size_t)s.rows[i]);
+}
+
+// value of all rows of selection
+template <typename SLOT>
+static void fill(SLOT& slot, const expr::SELECTION& s, const expr::value v, const size_t count) {
+
+	if ( !s.dense ) {
+		each(s, [&](size_t r) { slot.put(r, v, count); });
+		return;
+	}
+
+	slot.numeric = v.is_number();
+
+	if ( slot.numeric )
+		std::fill(slot.numbers.begin(), slot.numbers.begin() + s.count, v.number());
+	else std::fill(slot.values.begin(), slot.values.begin() + s.count, v);
+}
+
+// true when rows 0 ... count - 1 are numbers, they are moved to numbers of slot
+template <typename SLOT>
+static bool numbers(SLOT& slot, const size_t count) {
+
+	if ( slot.numeric )
+		return true;
+
+	for ( size_t i = 0; i < count; i++ )
+		if ( !slot.values[i].is_number())
+			return false;
+
+	for ( size_t i = 0; i < count; i++ )
+		slot.numbers[i] = slot.values[i].number();
+
+	slot.numeric = true;
+	return true;
+}
+
+// rows of s are split to rows where slot is true and rows where it is false
+template <typename SLOT>
+static void split(const expr::context& ctx, const SLOT& slot, const expr::SELECTION& s, expr::SELECTION& t, expr::SELECTION& f) {
+
+	t.count = 0;
+	f.count = 0;
+
+	// row is written to both, without branch on unpredictable conditions
+	each(s, [&](size_t r) {
+
+		bool b = slot.numeric ? slot.numbers[r] != 0 : number(ctx, slot.values[r]) != 0;
+
+		t.rows[t.count] = (uint16_t)r;
+		f.rows[f.count] = (uint16_t)r;
+		t.count += b;
+		f.count += !b;
+	});
+
+	t.dense = s.dense && t.count == s.count;
+	f.dense = s.dense && f.count == s.count;
+}
+
+// evaluates rows base ... base + count - 1, or rows of within, to first slot of stack
+void expr::batch::execute(expr::context& ctx, const size_t base, const size_t count, const expr::SELECTION *within) {
+
+	const expr::program& p = this -> _program;
+	const INSTRUCTION *code = p._code.data();
+	const size_t size = p._code.size();
+	const symbols& names = symbols::global();
+	FUNCTION_ARGS& args = ctx.args();
+	SLOT *stack = this -> _stack.data();
+	FRAME *frames = this -> _frames.data();
+	SELECTION *selections = this -> _selections.data();
+	size_t sp = 0, depth = 0, allocated = 1, cur = 0, pc = 0;
+
+	selections[0].dense = within == nullptr || within -> dense;
+	selections[0].count = within == nullptr ? count : within -> count;
+
+	if ( !selections[0].dense )
+		std::copy(within -> rows.begin(), within -> rows.begin() + within -> count, selections[0].rows.begin());
+
+	while ( true ) {
+
+		// branches join
+		while ( depth > 0 && frames[depth - 1].end == pc ) {
+			depth--;
+			cur = frames[depth].saved;
+			allocated = frames[depth].mark;
+		}
+
+		if ( pc >= size )
+			break;
+
+		const INSTRUCTION& in = code[pc];
+		const SELECTION& s = selections[cur];
+
+		switch ( in.code ) {
+
+			case expr::I_CONST:
+				fill(stack[sp++], s, from_constant(ctx, p._strings, p._constants[in.a]), count);
 				break;
 
-			case OP_NGT:
-
-				if ( tokens.size() > 2 ) {
-					process_rhs_token(tokens, 2, 3);
-					if ( tokens[0].is_string() || tokens[2].is_string())
-						tokens[2] = TOKEN::SGT(tokens[0].to_string(), tokens[2].to_string());
-					else
-						tokens[2] = TOKEN::NGT(tokens[0].to_double(), tokens[2].to_double());
-					tokens.erase(tokens.begin(), tokens.begin() + 2);
-				} else {
-					logger::error["evaluate"] << "operator NGT(>) with missing right side value" << std::endl;
-					tokens.erase(tokens.begin() + 1);
-				}
+			case expr::I_LOAD:
+				fill(stack[sp++], s, from_constant(ctx, p._strings, p._constants[in.b]), count);
 				break;
 
-			case OP_NGE:
-
-				if ( tokens.size() > 2 ) {
-					process_rhs_token(tokens, 2, 3);
-					if ( tokens[0].is_string() || tokens[2].is_string())
-						tokens[2] = TOKEN::SGE(tokens[0].to_string(), tokens[2].to_string());
-					else
-						tokens[2] = TOKEN::NGE(tokens[0].to_double(), tokens[2].to_double());
-					tokens.erase(tokens.begin(), tokens.begin() + 2);
-				} else {
-					logger::error["evaluate"] << "operator NGE(>=) with missing right side value" << std::endl;
-					tokens.erase(tokens.begin() + 1);
+			case expr::I_SLOT: {
+					const COLUMN& c = this -> _columns[in.a];
+					SLOT& slot = stack[sp++];
+
+					if ( c.type == C_NUMBERS && s.dense ) {
+						slot.numeric = true;
+						std::copy(c.numbers.begin() + base, c.numbers.begin() + base + count, slot.numbers.begin());
+					} else if ( c.type == C_NUMBERS )
+						each(s, [&](size_t r) { slot.put(r, value::NUMBER(c.numbers[base + r]), count); });
+					else if ( c.type == C_STRINGS )
+						each(s, [&](size_t r) { slot.put(r, value::STRING(ctx.view(c.strings[base + r])), count); });
+					else fill(slot, s, c.scalar.is_null() ? value::STRING(0) : to_value(ctx, c.scalar), count);
 				}
 				break;
 
-			/* string comparators */
-			case OP_SEQ:
+			case expr::I_CALL:
+			case expr::I_LINKED: {
+					expr::FUNCTION *f = in.code == expr::I_LINKED ? p._handles[in.a] :
+						function(names.string(p._names[in.a]), this -> _functions);
+					const std::string& name = names.string(p._names[in.a]);
 
-				if ( tokens.size() > 2 ) {
-					process_rhs_token(tokens, 2, 3);
-					tokens[2] = expr::TOKEN::SEQ(tokens[0].to_string(), tokens[2].to_string());
-					tokens.erase(tokens.begin(), tokens.begin() + 2);
-				} else {
-					logger::error["evaluate"] << "operator SEQ(eq) with missing right side value" << std::endl;
-					tokens.erase(tokens.begin() + 1);
+					sp -= in.b;
+
+					if ( f == nullptr ) {
+						fill(stack[sp++], s, value::NULLPTR(), count);
+						break;
+					}
+
+					// numeric function with array entry point is applied to whole chunk
+					if ( f -> is_vectorized() && s.dense && (size_t)f -> arity() == in.b &&
+						std::all_of(stack + sp, stack + sp + in.b,
+							[count](SLOT& slot) { return numbers(slot, count); })) {
+
+						const double *argv[2] = { stack[sp].numbers.data(), stack[sp + in.b - 1].numbers.data() };
+						f -> numeric(argv, std::span<double>(stack[sp].numbers.data(), count));
+						sp++;
+						break;
+					}
+
+					bool memo = memoizable(ctx, f, in.b);
+					this -> _argv.resize(in.b);
+					value *argv = this -> _argv.data();
+
+					// arguments of row are read before its result is stored to first of them
+					each(s, [&](size_t r) {
+
+						for ( size_t i = 0; i < in.b; i++ )
+							argv[i] = stack[sp + i].get(r);
+
+						stack[sp].put(r, memo ? memoized(ctx, p._id << 24 | pc, name, f, argv, in.b, args) :
+							call(ctx, name, f, argv, in.b, args), count);
+					});
+
+					sp++;
 				}
 				break;
 
-			case OP_SNE:
+			case expr::I_UNARY: {
+					SLOT& v = stack[sp - 1];
 
-				if ( tokens.size() > 2 ) {
-					process_rhs_token(tokens, 2, 3);
-					tokens[2] = expr::TOKEN::SNE(tokens[0].to_string(), tokens[2].to_string());
-					tokens.erase(tokens.begin(), tokens.begin() + 2);
-				} else {
-					logger::error["evaluate"] << "operator SNE(ne) with missing right side value" << std::endl;
-					tokens.erase(tokens.begin() + 1);
+					if ( in.op != expr::OP_SUB && in.op != expr::OP_NOT && in.op != expr::OP_NNOT )
+						break;
+
+					if ( s.dense && numbers(v, count)) {
+						std::span<double> n(v.numbers.data(), count);
+						expr::kernels::unary(in.op, n, n);
+						break;
+					}
+
+					each(s, [&](size_t r) {
+
+						double n = v.numeric ? v.numbers[r] : number(ctx, v.values[r]);
+						n = in.op == expr::OP_SUB ? expr::ops::SGN(n) :
+							( in.op == expr::OP_NOT ? expr::ops::NOT(n) : expr::ops::NNOT(n));
+						v.put(r, value::NUMBER(n), count);
+					});
 				}
 				break;
 
-			case OP_SLT:
+			case expr::I_BINARY: {
+					SLOT& lhs = stack[sp - 2];
+					SLOT& rhs = stack[sp - 1];
+
+					if ( s.dense && expr::kernels::is_binary(in.op) && numbers(lhs, count) && numbers(rhs, count)) {
+						std::span<double> n(lhs.numbers.data(), count);
+						expr::kernels::binary(in.op, n, std::span<const double>(rhs.numbers.data(), count), n);
+					} else if ( lhs.numeric && rhs.numeric && expr::kernels::is_binary(in.op)) {
+						each(s, [&](size_t r) { numeric(in.op, lhs.numbers[r], rhs.numbers[r], lhs.numbers[r]); });
+					} else each(s, [&](size_t r) {
 
-				if ( tokens.size() > 2 ) {
-					process_rhs_token(tokens, 2, 3);
-					tokens[2] = expr::TOKEN::SLT(tokens[0].to_string(), tokens[2].to_string());
-					tokens.erase(tokens.begin(), tokens.begin() + 2);
-				} else {
-					logger::error["evaluate"] << "operator SLT(lt) with missing right side value" << std::endl;
-					tokens.erase(tokens.begin() + 1);
+						value v = lhs.get(r);
+						apply(ctx, in.op, v, rhs.get(r));
+						lhs.put(r, v, count);
+					});
+
+					sp--;
 				}
 				break;
 
-			case OP_SLE:
+			case expr::I_JUMP_FALSE: {
+					// rows where condition is false are evaluated after rows where it is true
+					size_t t = allocated, f = allocated + 1;
+
+					frames[depth++] = { .end = code[in.a - 1].a, .saved = cur, .other = f, .mark = allocated, .sp = --sp };
+					allocated += 2;
+					split(ctx, stack[sp], s, selections[t], selections[f]);
 
-				if ( tokens.size() > 2 ) {
-					process_rhs_token(tokens, 2, 3);
-					tokens[2] = expr::TOKEN::SLE(tokens[0].to_string(), tokens[2].to_string());
-					tokens.erase(tokens.begin(), tokens.begin() + 2);
-				} else {
-					logger::error["evaluate"] << "operator SLE(le) with missing right side value" << std::endl;
-					tokens.erase(tokens.begin() + 1);
+					if ( selections[t].count == 0 ) {
+						cur = f;
+						pc = in.a;
+						continue;
+					}
+
+					cur = t;
 				}
 				break;
 
-			case OP_SGT:
+			case expr::I_JUMP: {
+					const FRAME& frame = frames[depth - 1];
+
+					if ( selections[frame.other].count == 0 ) {
+						pc = in.a;
+						continue;
+					}
 
-				if ( tokens.size() > 2 ) {
-					process_rhs_token(tokens, 2, 3);
-					tokens[2] = expr::TOKEN::SGT(tokens[0].to_string(), tokens[2].to_string());
-					tokens.erase(tokens.begin(), tokens.begin() + 2);
-				} else {
-					logger::error["evaluate"] << "operator SGT(gt) with missing right side value" << std::endl;
-					tokens.erase(tokens.begin() + 1);
+					cur = frame.other;
+					sp = frame.sp;
 				}
 				break;
 
-			case OP_SGE:
+			case expr::I_AND:
+			case expr::I_OR: {
+					// rows decided by left side get their result, others evaluate right side
+					size_t t = allocated, f = allocated + 1;
+					SLOT& v = stack[sp - 1];
+
+					split(ctx, v, s, selections[t], selections[f]);
+
+					size_t decided = in.code == expr::I_AND ? f : t;
+					size_t rest = in.code == expr::I_AND ? t : f;
+					value result = value::NUMBER(in.code == expr::I_AND ? 0 : 1);
 
-				if ( tokens.size() > 2 ) {
-					process_rhs_token(tokens, 2, 3);
-					tokens[2] = expr::TOKEN::SGE(tokens[0].to_string(), tokens[2].to_string());
-					tokens.erase(tokens.begin(), tokens.begin() + 2);
-				} else {
-					logger::error["evaluate"] << "operator SGE(>=) with missing right side value" << std::endl;
-					tokens.erase(tokens.begin() + 1);
+					each(selections[decided], [&](size_t r) { v.put(r, result, count); });
+
+					if ( selections[rest].count == 0 ) {
+						pc = in.a;
+						continue;
+					}
+
+					frames[depth++] = { .end = in.a, .saved = cur, .other = rest, .mark = allocated, .sp = --sp };
+					allocated += 2;
+					cur = rest;
 				}
 				break;
+		}
+
+		pc++;
+	}
+}
+
+const bool expr::batch::evaluate(expr::context& ctx, std::span<double> results) {
+
+	if ( !this -> check(results.size()))
+		return false;
+
+	for ( size_t base = 0; base < results.size(); base += CHUNK ) {
+
+		size_t count = std::min(CHUNK, results.size() - base);
+		double *result = results.data() + base;
 
+		if ( this -> _program._code.empty()) {
+			std::fill(result, result + count, expr::VARIABLE().to_double());
+			continue;
+		}
+
+		// strings of chunk are released when next chunk begins
+		evaluation_frame f(ctx, 0);
 
-			default:
-				logger::error["evaluate"] << "unhandled unknown operator " << describe(tokens[1]._op) << std::endl;
-				tokens.erase(tokens.begin());
+		try {
+			this -> execute(ctx, base, count);
+		} catch ( std::runtime_error& e ) {
+			aborted(e, "", nullptr);
+			std::fill(result, result + count, expr::VARIABLE().to_double());
+			continue;
 		}
 
-		return tokens;
+		const SLOT& slot = this -> _stack[0];
 
-	} else if ( tokens.size() > 1 && tokens[0] == T_NUMBER && tokens[1] == T_STRING ) {
+		if ( slot.numeric )
+			std::copy(slot.numbers.begin(), slot.numbers.begin() + count, result);
+		else for ( size_t i = 0; i < count; i++ )
+			result[i] = number(ctx, slot.values[i]);
+	}
 
-		if ( !tokens[1].to_string().empty())
-			tokens[0] = expr::TOKEN::STRING(tokens[0].to_string() + tokens[1].to_string());
-		tokens.erase(tokens.begin() + 1);
+	return true;
+}
 
-	} else if ( tokens.size() > 1 && tokens[0] == T_STRING && tokens[1] == T_NUMBER ) {
+const bool expr::batch::evaluate(expr::context& ctx, std::span<expr::VARIABLE> results) {
 
-		if ( !tokens[0].to_string().empty())
-			tokens[1] = expr::TOKEN::STRING(tokens[0].to_string() + tokens[1].to_string());
-		tokens.erase(tokens.begin());
+	if ( !this -> check(results.size()))
+		return false;
 
-	} else if ( tokens.size() > 1 && tokens[0] == T_NUMBER && tokens[1] == T_NUMBER ) {
+	for ( size_t base = 0; base < results.size(); base += CHUNK ) {
 
-		tokens[0] = expr::TOKEN::NUMBER(tokens[0].to_double() + tokens[1].to_double());
-		tokens.erase(tokens.begin() + 1);
+		size_t count = std::min(CHUNK, results.size() - base);
+		expr::VARIABLE *result = results.data() + base;
 
-	} else if ( tokens.size() > 1 && tokens[0] == T_STRING && tokens[1] == T_STRING ) {
+		if ( this -> _program._code.empty()) {
+			std::for_each(result, result + count, [](expr::VARIABLE& v) { v.emplace<std::nullptr_t>(nullptr); });
+			continue;
+		}
 
-		tokens[0] = expr::TOKEN::STRING(tokens[0].to_string() + tokens[1].to_string());
-		tokens.erase(tokens.begin() + 1);
+		evaluation_frame f(ctx, 0);
 
-	} else if ( tokens.size() > 1 && tokens[0] == T_UNDEF ) {
+		try {
+			this -> execute(ctx, base, count);
+		} catch ( std::runtime_error& e ) {
+			aborted(e, "", nullptr);
+			std::for_each(result, result + count, [](expr::VARIABLE& v) { v.emplace<std::nullptr_t>(nullptr); });
+			continue;
+		}
 
-		tokens.erase(tokens.begin());
+		const SLOT& slot = this -> _stack[0];
 
-	} else if ( tokens.size() > 1 && tokens[1] == T_UNDEF ) {
+		for ( size_t i = 0; i < count; i++ ) {
 
-		tokens.erase(tokens.begin() + 1);
+			value v = slot.get(i);
 
+			if ( v.is_number())
+				result[i].emplace<double>(v.number());
+			else if ( v.is_null())
+				result[i].emplace<std::nullptr_t>(nullptr);
+			else if ( std::string *s = std::get_if<std::string>(&result[i]))
+				s -> assign(ctx.string(v.string()));
+			else result[i].emplace<std::string>(ctx.string(v.string()));
+		}
 	}
 
-	return tokens;
+	return true;
 }
 
-expr::TOKEN expr::expression::evaluate(std::vector<expr::TOKEN>& tokens, expr::FUNCTIONMAP *functions, expr::VARIABLEMAP *variables) {
+// rows of _within where expression is true to _matched
+void expr::batch::match(expr::context& ctx, const size_t base, const size_t count) {
 
-	bool abort = false;
-	std::string set_variable;
+	this -> _matched.dense = false;
+	this -> _matched.count = 0;
 
-	if ( tokens.empty())
-		return expr::TOKEN::UNDEF();
+	if ( this -> _program._code.empty())
+		return;
 
-	if ( tokens.size() > 1 && tokens[1] == expr::OP_SET &&
-		tokens[0] == expr::T_VARIABLE && !tokens[0]._name.empty()) {
+	evaluation_frame f(ctx, 0);
 
-		set_variable = tokens[0]._name;
-		tokens.erase(tokens.begin(), tokens.begin() + 2);
+	try {
+		this -> execute(ctx, base, count, &this -> _within);
+	} catch ( std::runtime_error& e ) {
+		aborted(e, "", nullptr);
+		return;
 	}
 
-	begin_evaluate:
+	split(ctx, this -> _stack[0], this -> _within, this -> _matched, this -> _unmatched);
+}
+
+const bool expr::batch::filter(expr::context& ctx, const size_t rows, std::span<uint64_t> mask) {
 
-	while ( tokens.size() > 1 ) {
-		try {
-			tokens = eval(tokens, false, functions, variables);
-		} catch ( std::runtime_error& e ) {
-			logger::error["evaluate"] << e.what() << std::endl;
-			abort = true;
-		}
+	if ( mask.size() * 64 < rows ) {
+		logger::error["evaluate"] << "filter of <" << this -> _expression.raw() << "> has " << rows <<
+			" rows, mask has " << mask.size() * 64 << std::endl;
+		return false;
 	}
 
-	if ( !abort && tokens.front() == expr::T_VARIABLE ) {
-		try {
-			tokens = eval(tokens, false, functions, variables);
-		} catch ( std::runtime_error& e ) {
-			logger::error["evaluate"] << e.what() << std::endl;
-			abort = true;
-		}
-		if ( !abort ) goto begin_evaluate;
+	if ( !this -> check(rows))
+		return false;
+
+	std::fill(mask.begin(), mask.end(), 0);
+
+	for ( size_t base = 0; base < rows; base += CHUNK ) {
+
+		size_t count = std::min(CHUNK, rows - base);
+
+		this -> _within.dense = true;
+		this -> _within.count = count;
+		this -> match(ctx, base, count);
+
+		// CHUNK is a multiple of 64, words of mask are not shared by chunks
+		uint64_t *words = mask.data() + base / 64;
+		each(this -> _matched, [&](size_t r) { words[r / 64] |= (uint64_t)1 << ( r % 64 ); });
 	}
 
-	if ( !abort && tokens.front() == expr::T_FUNCTION ) {
-		try {
-			tokens = eval(tokens, false, functions, variables);
-		} catch ( std::runtime_error& e ) {
-			logger::error["evaluate"] << e.what() << std::endl;
-			abort = true;
-		}
-		if ( !abort ) goto begin_evaluate;
+	return true;
+}
+
+const bool expr::batch::filter(expr::context& ctx, const size_t rows, std::vector<uint32_t>& selected) {
+
+	selected.clear();
+
+	if ( !this -> check(rows))
+		return false;
+
+	for ( size_t base = 0; base < rows; base += CHUNK ) {
+
+		size_t count = std::min(CHUNK, rows - base);
+
+		this -> _within.dense = true;
+		this -> _within.count = count;
+		this -> match(ctx, base, count);
+
+		each(this -> _matched, [&](size_t r) { selected.push_back((uint32_t)( base + r )); });
 	}
 
-	if ( !abort && tokens.front() == expr::T_SUB && !tokens.front()._child.empty()) {
-		tokens = tokens.front()._child;
-		goto begin_evaluate;
+	return true;
+}
+
+const bool expr::batch::filter(expr::context& ctx, std::span<const uint32_t> rows, std::vector<uint32_t>& selected) {
+
+	selected.clear();
+
+	if ( !std::is_sorted(rows.begin(), rows.end(), std::less_equal<uint32_t>())) {
+		logger::error["evaluate"] << "filter of <" << this -> _expression.raw() << "> has rows that are not in ascending order or repeat" << std::endl;
+		return false;
 	}
 
-	if ( !abort && tokens.front() == expr::OP_SUB ) {
-		if ( tokens.size() > 1 ) goto begin_evaluate;
-		try {
-			tokens = eval(tokens, false, functions, variables);
-		} catch ( std::runtime_error&e ) {
-			logger::error["evaluate"] << e.what() << std::endl;
-			abort = true;
+	if ( rows.empty() || !this -> check((size_t)rows.back() + 1))
+		return rows.empty();
+
+	for ( size_t i = 0; i < rows.size(); ) {
+
+		// rows of same chunk are evaluated together, from first of them
+		size_t base = rows[i], count = 0;
+		this -> _within.count = 0;
+
+		for ( ; i < rows.size() && rows[i] < base + CHUNK; i++ ) {
+			count = rows[i] - base + 1;
+			this -> _within.rows[this -> _within.count++] = (uint16_t)( rows[i] - base );
 		}
+
+		this -> _within.dense = this -> _within.count == count;
+		this -> match(ctx, base, count);
+
+		each(this -> _matched, [&](size_t r) { selected.push_back((uint32_t)( base + r )); });
 	}
 
-	if ( !abort && tokens.size() == 1 ) {
+	return true;
+}
 
-		if ( !set_variable.empty() && variables != nullptr ) {
+#if defined(EXPR_THREADED_DISPATCH) && !defined(__GNUC__)
+#undef EXPR_THREADED_DISPATCH
+#endif
+
+#ifdef EXPR_THREADED_DISPATCH
+#define VM_START goto *handlers[pc];
+#define VM_CASE(name) L_##name:
+#define VM_NEXT pc++; goto *handlers[pc]
+#define VM_JUMP(target) pc = target; goto *handlers[pc]
+#define VM_END
+#else
+#define VM_START while ( true ) { switch ( code[pc].code ) {
+#define VM_CASE(name) case expr::name:
+#define VM_NEXT pc++; continue
+#define VM_JUMP(target) pc = target; continue
+#define VM_END }}
+#endif
+
+// registers of register program run on this thread. Runs nested by
+// function calls get their own frames. Constants are copied to frame
+// only when it was last used by another program
+struct RFRAME {
+
+	uint64_t program = 0;
+	std::vector<expr::VARIABLE> registers;
+	expr::FUNCTION_ARGS args;
+};
+
+static thread_local std::vector<std::unique_ptr<RFRAME>> frames;
+static thread_local size_t frames_used = 0;
+
+expr::TOKEN expr::register_program::run(expr::FUNCTIONMAP *functions, expr::VARIABLEMAP *variables) const {
+
+	return this -> execute(functions, variables, nullptr);
+}
 
-			if ( tokens.front().is_number())
-				(*variables)[set_variable] = tokens.front().to_double();
-			else if ( tokens.front().is_string())
-				(*variables)[set_variable] = tokens.front().to_string();
-			else {
-				logger::verbose["evaluate"] << "ambiguos result of expr, variable " << set_variable <<
-					" was set to null" << std::endl;
-				(*variables)[set_variable] = nullptr;
-			}
-		}
-		return tokens.front();
+// runs program, or only fills handlers of instructions for threaded
+// dispatch, when handlers is not nullptr
+expr::TOKEN expr::register_program::execute(expr::FUNCTIONMAP *functions, expr::VARIABLEMAP *variables, std::vector<const void*> *handlers_of) const {
 
+#ifdef EXPR_THREADED_DISPATCH
+	static const void* labels[] = {
+		&&L_R_HALT, &&L_R_MOVE, &&L_R_LOAD, &&L_R_CALL, &&L_R_CALL0,
+		&&L_R_UNARY, &&L_R_BINARY, &&L_R_LOAD_CMP_CONST, &&L_R_LOAD_MUL_CONST,
+		&&L_R_JUMP, &&L_R_JUMP_FALSE, &&L_R_AND, &&L_R_OR
+	};
+
+	if ( handlers_of != nullptr ) {
+
+		handlers_of -> resize(this -> _code.size());
+
+		for ( size_t i = 0; i < this -> _code.size(); i++ )
+			(*handlers_of)[i] = labels[this -> _code[i].code];
 	}
 
-	if ( abort )
-		logger::warning["evaluate"] << "evaluation was aborted because of errors";
-	else
-		logger::warning["evaluate"] << "evaluating ended up with ambiguous results, result will be null";
+	const void* const *handlers = this -> _handlers.data();
+#endif
 
-	if ( !set_variable.empty() && variables != nullptr ) {
-		logger::warning << " and variable " << set_variable << " was set to nullptr";
-		(*variables)[set_variable] = nullptr;
+	if ( this -> _code.empty() || handlers_of != nullptr )
+		return expr::TOKEN::UNDEF();
+
+	if ( frames_used == frames.size())
+		frames.push_back(std::make_unique<RFRAME>());
+
+	struct RELEASE { ~RELEASE() { frames_used--; }} release;
+	RFRAME& frame = *frames[frames_used++];
+
+	if ( frame.program != this -> _id ) {
+		frame.registers.assign(this -> _registers.begin(), this -> _registers.end());
+		frame.program = this -> _id;
 	}
 
-	logger::warning << std::endl;
-	return expr::TOKEN::UNDEF();
-}
+	const RINSTRUCTION *code = this -> _code.data();
+	const symbols& names = symbols::global();
+	VARIABLE *r = frame.registers.data();
+	size_t pc = 0;
 
-expr::TOKEN expr::expression::evaluate(expr::FUNCTIONMAP *functions, expr::VARIABLEMAP *variables) {
+	try {
 
-	std::vector<expr::TOKEN> tokens = this -> _tokens;
-	expr::TOKEN result = evaluate(tokens, functions, variables);
+		VM_START
 
-	return result;
-}
+		VM_CASE(R_HALT)
+			return finished(r[code[pc].a], this -> _set_variable, variables);
 
-expr::TOKEN expr::expression::evaluate(const std::string& s, expr::FUNCTIONMAP *functions, expr::VARIABLEMAP *variables) {
+		VM_CASE(R_MOVE)
+			r[code[pc].dst] = r[code[pc].a];
+			VM_NEXT;
 
-	this -> _raw = s;
-	this -> _tokens = parse_expr(s);
+		VM_CASE(R_LOAD)
+			r[code[pc].dst] = load(names.string(this -> _names[code[pc].a]), r[code[pc].b], variables);
+			VM_NEXT;
 
-	std::vector<expr::TOKEN> tokens = this -> _tokens;
-	expr::TOKEN result = evaluate(tokens, functions, variables);
+		VM_CASE(R_CALL) {
+				const RINSTRUCTION& in = code[pc];
+				expr::FUNCTION *f = function(names.string(this -> _names[in.a]), functions);
 
-	return result;
+				if ( f == nullptr )
+					r[in.dst].emplace<std::nullptr_t>(nullptr);
+				else call(names.string(this -> _names[in.a]), f, expr::FUNCTION_ARGS_VIEW(r + in.dst, in.b), frame.args, r[in.dst]);
+			}
+			VM_NEXT;
+
+		VM_CASE(R_CALL0) {
+				const RINSTRUCTION& in = code[pc];
+				const std::string& name = names.string(this -> _names[in.a]);
+				expr::FUNCTION *f = functions != nullptr && functions -> contains(name) ?
+					&(*functions)[name] : this -> _builtins[in.b];
+
+				call(name, f, expr::FUNCTION_ARGS_VIEW(), frame.args, r[in.dst]);
+			}
+			VM_NEXT;
+
+		VM_CASE(R_UNARY) {
+				const RINSTRUCTION& in = code[pc];
+				double n = number(r[in.a]);
+
+				switch ( in.op ) {
+					case expr::OP_SUB: r[in.dst].emplace<double>(expr::ops::SGN(n)); break;
+					case expr::OP_NOT: r[in.dst].emplace<double>(expr::ops::NOT(n)); break;
+					default: r[in.dst].emplace<double>(expr::ops::NNOT(n)); break;
+				}
+			}
+			VM_NEXT;
+
+		VM_CASE(R_BINARY)
+			apply(code[pc].op, r[code[pc].dst], r[code[pc].a], r[code[pc].b]);
+			VM_NEXT;
+
+		VM_CASE(R_LOAD_CMP_CONST)
+		VM_CASE(R_LOAD_MUL_CONST) {
+				const RINSTRUCTION& in = code[pc];
+				apply(in.op, r[in.dst], load(names.string(this -> _names[in.a]), r[in.b], variables), r[in.c]);
+			}
+			VM_NEXT;
+
+		VM_CASE(R_JUMP)
+			VM_JUMP(code[pc].a);
+
+		VM_CASE(R_JUMP_FALSE)
+			if ( number(r[code[pc].a]) == 0 ) {
+				VM_JUMP(code[pc].b);
+			}
+			VM_NEXT;
+
+		VM_CASE(R_AND)
+			if ( number(r[code[pc].a]) == 0 ) {
+				r[code[pc].a].emplace<double>(0);
+				VM_JUMP(code[pc].b);
+			}
+			VM_NEXT;
+
+		VM_CASE(R_OR)
+			if ( number(r[code[pc].a]) != 0 ) {
+				r[code[pc].a].emplace<double>(1);
+				VM_JUMP(code[pc].b);
+			}
+			VM_NEXT;
+
+		VM_END
+
+	} catch ( std::runtime_error& e ) {
+		return aborted(e, this -> _set_variable, variables);
+	}
+
+	return expr::TOKEN::UNDEF();
 }
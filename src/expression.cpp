@@ -1,31 +1,114 @@
+#include <atomic>
 #include <sstream>
+#include "expr/symbols.hpp"
+#include "expr/variable_store.hpp"
 #include "expr/expression.hpp"
 
 const std::string expr::expression::raw() const {
 	return this -> _raw;
 }
 
-const std::vector<expr::TOKEN>& expr::expression::tokens() {
-	return this -> _tokens;
+const expr::TOKEN expr::expression::root() const {
+	return this -> _tree.root();
 }
 
-const std::vector<expr::TOKEN> expr::expression::tokens() const {
-	return this -> _tokens;
+const expr::tree& expr::expression::syntax_tree() const {
+	return this -> _tree;
+}
+
+const expr::program& expr::expression::compiled() const {
+	return this -> _program;
 }
 
 expr::expression::operator std::string() const {
-	return !this -> _tokens.empty() ? describe(this -> _tokens) : "";
+	return this -> _tree.empty() ? "" : describe_expr(this -> _tree.root());
 }
 
 const std::string expr::expression::to_string() const {
 	return operator std::string();
 }
 
+const bool expr::expression::is_constant(expr::FUNCTIONMAP *functions, expr::VARIABLEMAP *variables) const {
+	return this -> _constant && this -> assumptions_hold(functions, variables);
+}
+
+const expr::VARIABLE expr::expression::constant_value() const {
+	return this -> _value;
+}
+
+const bool expr::expression::assumptions_hold(expr::FUNCTIONMAP *functions, expr::VARIABLEMAP *variables) const {
+
+	if ( variables != nullptr && !variables -> empty())
+		for ( const std::string& name : this -> _assumed_variables )
+			if ( variables -> contains(name))
+				return false;
+
+	if ( functions != nullptr && !functions -> empty())
+		for ( const std::string& name : this -> _assumed_functions )
+			if ( functions -> contains(name))
+				return false;
+
+	return true;
+}
+
+const bool expr::expression::assumptions_hold(expr::context& ctx, expr::FUNCTIONMAP *functions, expr::VARIABLEMAP *variables) const {
+
+	if ( this -> _id == 0 )
+		return true;
+
+	size_t functions_size = functions == nullptr ? 0 : functions -> size();
+	size_t variables_size = variables == nullptr ? 0 : variables -> size();
+	expr::context::ASSUMPTION& a = ctx.assumption(this -> _id);
+
+	if ( a.expression != this -> _id || a.functions != functions || a.variables != variables ||
+		a.functions_size != functions_size || a.variables_size != variables_size )
+		a = {
+			.expression = this -> _id,
+			.functions = functions,
+			.variables = variables,
+			.functions_size = functions_size,
+			.variables_size = variables_size,
+			.hold = this -> assumptions_hold(functions, variables)
+		};
+
+	return a.hold;
+}
+
+// variables of store are found by their symbols, without case folding names
+const bool expr::expression::assumptions_hold(expr::context& ctx, expr::FUNCTIONMAP *functions, const expr::variable_store& variables) const {
+
+	for ( const expr::SYMBOL id : this -> _assumed_symbols )
+		if ( variables.is_set(variables.find(id)))
+			return false;
+
+	return this -> assumptions_hold(ctx, functions, nullptr);
+}
+
 void expr::expression::parse(const std::string& s) {
+
+	TOKEN root = parse_expr(s);
+
 	this -> _raw = s;
-	if ( this -> _tokens.empty())
-		this -> _tokens.push_back(expr::TOKEN::UNDEF());
-	this -> _tokens = parse_expr(s);
+	this -> _tree = expr::tree(root);
+	this -> _assumed_variables.clear();
+	this -> _assumed_functions.clear();
+
+	TOKEN folded = fold(root, this -> _assumed_variables, this -> _assumed_functions);
+
+	static std::atomic<uint64_t> ids(0);
+
+	this -> _assumed_symbols.clear();
+	this -> _id = this -> _assumed_variables.empty() && this -> _assumed_functions.empty() ? 0 : ++ids;
+
+	for ( const std::string& name : this -> _assumed_variables )
+		this -> _assumed_symbols.push_back(expr::symbols::global().identifier(name));
+
+	this -> _program = expr::program(folded);
+	this -> _unfolded = this -> _assumed_variables.empty() && this -> _assumed_functions.empty() ?
+		expr::program() : expr::program(root);
+
+	this -> _constant = folded == expr::T_NUMBER || folded == expr::T_STRING;
+	this -> _value = this -> _constant ? VARIABLE(folded.value()) : VARIABLE();
 }
 
 expr::expression::expression() {
@@ -40,16 +123,16 @@ expr::expression::expression(const std::string& s) {
 
 expr::expression::~expression() {
 	this -> _raw = std::string();
-	this -> _tokens.clear();
+	this -> _tree = expr::tree();
+	this -> _program = expr::program();
+	this -> _unfolded = expr::program();
 }
 
 const std::string describe(const expr::expression& e) {
 
-	auto t = e.tokens();
-
-	if ( t.empty() || ( t.size() == 1 && t[0] == expr::T_UNDEF ))
+	if ( e.syntax_tree().empty())
 		return "nullptr";
-	return describe(t);
+	return describe_expr(e.root());
 }
 
 std::ostream& expr::operator <<(std::ostream& os, expr::expression const& e) {
@@ -1,11 +1,105 @@
 #include <ctime>
+#include <cmath>
+#include <cerrno>
+#include <cfloat>
 #include <iomanip>
 #include <cstring>
+#include <algorithm>
+#include <atomic>
+
+#if defined(__GNUC__) && ( defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#endif
 
 #include "logger.hpp"
 #include "expr/function.hpp"
+#include "expr/context.hpp"
+#include "expr/time_format.hpp"
+#include "expr/kernels.hpp"
+
+expr::FUNCTION::FUNCTION() {
+}
+
+expr::FUNCTION::FUNCTION(std::function<expr::VARIABLE(expr::FUNCTION_ARGS_VIEW)> f, const int arity) : _native(std::move(f)), _arity(arity) {
+}
+
+const bool expr::FUNCTION::is_native() const {
+	return this -> _native ? true : false;
+}
+
+const int expr::FUNCTION::arity() const {
+	return this -> _arity;
+}
+
+const expr::PURITY expr::FUNCTION::purity() const {
+	return this -> _purity;
+}
+
+void expr::FUNCTION::set_purity(const expr::PURITY purity) {
+	this -> _purity = purity;
+}
+
+const uint64_t expr::FUNCTION::generation() const {
+	return this -> _generation;
+}
+
+uint64_t expr::FUNCTION::next_generation() {
+
+	static std::atomic<uint64_t> generation(0);
+	return ++generation;
+}
+
+expr::FUNCTION expr::pure(expr::FUNCTION f) {
+
+	f.set_purity(expr::F_PURE);
+	return f;
+}
+
+expr::FUNCTION expr::per_tick(expr::FUNCTION f) {
+
+	f.set_purity(expr::F_PER_TICK);
+	return f;
+}
+
+expr::FUNCTION expr::vectorized(expr::FUNCTION f, expr::ARRAY_FUNCTION1 array) {
+
+	if ( !f.is_numeric() || f.arity() != 1 ) {
+		logger::warning["function"] << "array entry point of 1 argument ignored, function is not a numeric function of 1 argument" << std::endl;
+		return f;
+	}
+
+	f._array = (void(*)())array;
+	return f;
+}
+
+expr::FUNCTION expr::vectorized(expr::FUNCTION f, expr::ARRAY_FUNCTION2 array) {
+
+	if ( !f.is_numeric() || f.arity() != 2 ) {
+		logger::warning["function"] << "array entry point of 2 arguments ignored, function is not a numeric function of 2 arguments" << std::endl;
+		return f;
+	}
+
+	f._array = (void(*)())array;
+	return f;
+}
+
+expr::VARIABLE expr::FUNCTION::operator()(const expr::FUNCTION_ARGS& args) const {
+
+	if ( this -> _native )
+		return this -> _native(expr::FUNCTION_ARGS_VIEW(args));
+
+	return this -> _boxed(args);
+}
+
+expr::VARIABLE expr::FUNCTION::operator()(expr::FUNCTION_ARGS_VIEW args) const {
+
+	if ( this -> _native )
+		return this -> _native(args);
+
+	return this -> _boxed(expr::FUNCTION_ARGS(args.begin(), args.end()));
+}
 
-static double arg_to_double(const expr::VARIABLE& var) {
+double expr::functions::to_number(const expr::VARIABLE& var) {
 
 	double d = 0;
 	if ( var == expr::V_NUMBER )
@@ -26,53 +120,71 @@ static double arg_to_double(const expr::VARIABLE& var) {
 	return d;
 }
 
-expr::VARIABLE expr::functions::time_unixtime(const expr::FUNCTION_ARGS& args) {
+// time of running evaluation, see context::now()
+static std::chrono::system_clock::time_point now() {
 
-	std::chrono::seconds s = std::chrono::duration_cast<std::chrono::seconds>
-		(std::chrono::system_clock::now().time_since_epoch());
+	expr::context *ctx = expr::context::current();
+	return ctx == nullptr ? std::chrono::system_clock::now() : ctx -> now();
+}
 
-	double d = (double)s.count();
-	return d;
+// local time of running evaluation, converted once for each time of evaluation
+static std::tm local_time() {
+
+	if ( expr::context *ctx = expr::context::current(); ctx != nullptr )
+		return ctx -> local_time();
+
+	std::time_t t = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+	std::tm tm;
+
+	localtime_r(&t, &tm);
+	return tm;
 }
 
-expr::VARIABLE expr::functions::time_hour(const expr::FUNCTION_ARGS& args) {
+double expr::functions::time_unixtime() {
+
+	std::chrono::seconds s = std::chrono::duration_cast<std::chrono::seconds>(now().time_since_epoch());
 
-	return (double)common::to_tm().tm_hour;
+	return (double)s.count();
 }
 
-expr::VARIABLE expr::functions::time_min(const expr::FUNCTION_ARGS& args) {
+double expr::functions::time_hour() {
 
-	return (double)common::to_tm().tm_min;
+	return (double)local_time().tm_hour;
 }
 
-expr::VARIABLE expr::functions::time_sec(const expr::FUNCTION_ARGS& args) {
+double expr::functions::time_min() {
 
-	return (double)common::to_tm().tm_sec;
+	return (double)local_time().tm_min;
 }
 
-expr::VARIABLE expr::functions::date_day(const expr::FUNCTION_ARGS& args) {
+double expr::functions::time_sec() {
 
-	return (double)common::to_tm().tm_mday;
+	return (double)local_time().tm_sec;
 }
 
-expr::VARIABLE expr::functions::date_month(const expr::FUNCTION_ARGS& args) {
+double expr::functions::date_day() {
 
-	return (double)(common::to_tm().tm_mon + 1);
+	return (double)local_time().tm_mday;
 }
 
-expr::VARIABLE expr::functions::date_year(const expr::FUNCTION_ARGS& args) {
+double expr::functions::date_month() {
 
-	return (double)(common::to_tm().tm_year + 1900);
+	return (double)(local_time().tm_mon + 1);
 }
 
-expr::VARIABLE expr::functions::date_weekday(const expr::FUNCTION_ARGS& args) {
+double expr::functions::date_year() {
 
-	return (double)common::to_tm().tm_wday;
+	return (double)(local_time().tm_year + 1900);
 }
 
-expr::VARIABLE expr::functions::date_day_name(const expr::FUNCTION_ARGS& args) {
+double expr::functions::date_weekday() {
 
-	switch ( common::to_tm().tm_wday ) {
+	return (double)local_time().tm_wday;
+}
+
+std::string expr::functions::date_day_name() {
+
+	switch ( local_time().tm_wday ) {
 		case 0: return "Sun";
 		case 1: return "Mon";
 		case 2: return "Tue";
@@ -84,7 +196,7 @@ expr::VARIABLE expr::functions::date_day_name(const expr::FUNCTION_ARGS& args) {
 	}
 }
 
-expr::VARIABLE expr::functions::strftime(const expr::FUNCTION_ARGS& args) {
+expr::VARIABLE expr::functions::strftime(expr::FUNCTION_ARGS_VIEW args) {
 
 	if ( args.empty()) {
 		logger::warning["function"] << "strftime needs 1 argument for format and optionally a timestamp as second argument, 0 arguments given" << std::endl;
@@ -99,147 +211,114 @@ expr::VARIABLE expr::functions::strftime(const expr::FUNCTION_ARGS& args) {
 		return "";
 	}
 
-	std::chrono::seconds ds =
-		args.size() > 1 && args[1].number_convertible().empty() ? common::mk_duration(args[1].to_double()) : common::mk_duration();
+	std::tm tm;
+	std::string result;
+
+	if ( args.size() > 1 ) {
+
+		std::time_t t = (std::time_t)common::mk_duration(args[1].to_double()).count();
+		localtime_r(&t, &tm);
 
-	return common::put_time(args[0].to_string(), ds);
+	} else tm = local_time();
+
+	expr::time_format::cached(args[0].to_string()).format(tm, result);
+	return result;
 }
 
-expr::VARIABLE expr::functions::to_string(const expr::FUNCTION_ARGS& args) {
+std::string expr::functions::to_string(const expr::VARIABLE& v) {
 
-	if ( args.empty())
-		return "";
-	else if ( args[0] == expr::V_NUMBER ) {
-		double d = (double)args[0].to_double();
+	if ( v == expr::V_NUMBER ) {
+		double d = (double)v.to_double();
 		return common::to_string(d);
-	} else if ( args[0] == expr::V_STRING ) {
-		return args[0].to_string().empty() ? "" : (std::string)args[0];
+	} else if ( v == expr::V_STRING ) {
+		return v.to_string().empty() ? "" : (std::string)v;
 	} else return "";
 }
 
-expr::VARIABLE expr::functions::to_double(const expr::FUNCTION_ARGS& args) {
+double expr::functions::to_double(double d) {
 
-	if ( args.empty())
-		return (double)0;
-	else return arg_to_double(args[0]);
+	return d;
 }
 
-expr::VARIABLE expr::functions::to_int(const expr::FUNCTION_ARGS& args) {
-
-	int i = 0;
-	if ( args.empty())
-		i = 0;
-	else i = (int)arg_to_double(args[0]);
+double expr::functions::to_int(double d) {
 
-	return i;
+	return (double)(int)d;
 }
 
-expr::VARIABLE expr::functions::to_bool(const expr::FUNCTION_ARGS& args) {
+bool expr::functions::to_bool(double d) {
 
-	bool b = false;
-
-	if ( args.empty())
-		b = false;
-	else b = arg_to_double(args[0]) == 0 ? false : true;
-
-	return b;
+	return d == 0 ? false : true;
 }
 
-expr::VARIABLE expr::functions::is_odd(const expr::FUNCTION_ARGS& args) {
+bool expr::functions::is_odd(double d) {
 
-	int i = args.empty() ? 0 : (int)arg_to_double(args[0]);
-	bool b = i % 2 == 0 ? false : true;
-	return b;
+	int i = (int)d;
+	return i % 2 == 0 ? false : true;
 }
 
-expr::VARIABLE expr::functions::is_even(const expr::FUNCTION_ARGS& args) {
+bool expr::functions::is_even(double d) {
 
-	int i = args.empty() ? 0 : (int)arg_to_double(args[0]);
-	bool b = i % 2 == 0 ? true : false;
-	return b;
+	int i = (int)d;
+	return i % 2 == 0 ? true : false;
 }
 
-expr::VARIABLE expr::functions::sqrt(const expr::FUNCTION_ARGS& args) {
+double expr::functions::sqrt(double d) {
 
-	double d = args.empty() ? (double)0 : arg_to_double(args[0]);
-	d = std::sqrt(d);
-	return d;
+	return std::sqrt(d);
 }
-expr::VARIABLE expr::functions::exp(const expr::FUNCTION_ARGS& args) {
 
-	double d = args.empty() ? (double)0 : arg_to_double(args[0]);
-	d = std::exp(d);
-	return d;
+double expr::functions::exp(double d) {
+
+	return std::exp(d);
 }
 
-expr::VARIABLE expr::functions::ln(const expr::FUNCTION_ARGS& args) {
+double expr::functions::ln(double d) {
 
-	double d = args.empty() ? (double)0 : arg_to_double(args[0]);
-	d = std::log(d);
-	return d;
+	return std::log(d);
 }
 
-expr::VARIABLE expr::functions::log(const expr::FUNCTION_ARGS& args) {
+double expr::functions::log(double d) {
 
-	double d = args.empty() ? (double)0 : arg_to_double(args[0]);
-	d = std::log10(d);
-	return d;
+	return std::log10(d);
 }
 
-expr::VARIABLE expr::functions::sin(const expr::FUNCTION_ARGS& args) {
+double expr::functions::sin(double d) {
 
-	double d = args.empty() ? (double)0 : arg_to_double(args[0]);
-	d = std::sin(d);
-	return d;
+	return std::sin(d);
 }
 
-expr::VARIABLE expr::functions::cos(const expr::FUNCTION_ARGS& args) {
+double expr::functions::cos(double d) {
 
-	double d = args.empty() ? (double)0 : arg_to_double(args[0]);
-	d = std::cos(d);
-	return d;
+	return std::cos(d);
 }
 
-expr::VARIABLE expr::functions::tan(const expr::FUNCTION_ARGS& args) {
+double expr::functions::tan(double d) {
 
-	double d = args.empty() ? (double)0 : arg_to_double(args[0]);
-	d = std::tan(d);
-	return d;
+	return std::tan(d);
 }
 
-expr::VARIABLE expr::functions::min(const expr::FUNCTION_ARGS& args) {
+double expr::functions::min(double d1, double d2) {
 
-	double d1 = args.size() < 1 ? (double)0 : arg_to_double(args[0]);
-	double d2 = args.size() < 2 ? (double)0 : arg_to_double(args[1]);
-	d1 = std::min(d1, d2);
-	return d1;
+	return std::min(d1, d2);
 }
 
-expr::VARIABLE expr::functions::max(const expr::FUNCTION_ARGS& args) {
+double expr::functions::max(double d1, double d2) {
 
-	double d1 = args.size() < 1 ? (double)0 : arg_to_double(args[0]);
-	double d2 = args.size() < 2 ? (double)0 : arg_to_double(args[1]);
-	d1 = std::max(d1, d2);
-	return d1;
+	return std::max(d1, d2);
 }
 
-expr::VARIABLE expr::functions::floor(const expr::FUNCTION_ARGS& args) {
+double expr::functions::floor(double d) {
 
-	double d = args.empty() ? (double)0 : arg_to_double(args[0]);
-	d = std::floor(d);
-	return d;
+	return std::floor(d);
 }
 
-expr::VARIABLE expr::functions::ceil(const expr::FUNCTION_ARGS& args) {
+double expr::functions::ceil(double d) {
 
-	double d = args.empty() ? (double)0 : arg_to_double(args[0]);
-	d = std::ceil(d);
-	return d;
+	return std::ceil(d);
 }
 
-expr::VARIABLE expr::functions::round(const expr::FUNCTION_ARGS& args) {
+double expr::functions::round(double d) {
 
-	double d = args.empty() ? (double)0 : arg_to_double(args[0]);
 	int i;
 
 	if ( d > 0 )
@@ -248,35 +327,276 @@ expr::VARIABLE expr::functions::round(const expr::FUNCTION_ARGS& args) {
 		i = (int)(d - 0.5);
 	else i = 0;
 
-	return i;
+	return (double)i;
+}
+
+/* array entry points of math builtins */
+
+#if defined(__GNUC__) && ( defined(__x86_64__) || defined(__i386__))
+#define EXPR_ARRAYS_X86
+#endif
+
+#if defined(EXPR_ARRAYS_X86) && defined(EXPR_LIBMVEC)
+#define EXPR_ARRAYS_MVEC
+#endif
+
+static double power(double x, double y) {
+
+	return std::pow(x, y);
+}
+
+template <typename F>
+static void each(std::span<const double> d, std::span<double> result, F f) {
+
+	for ( size_t i = 0; i < result.size(); i++ )
+		result[i] = f(d[i]);
+}
+
+template <typename F>
+static void each(std::span<const double> d1, std::span<const double> d2, std::span<double> result, F f) {
+
+	for ( size_t i = 0; i < result.size(); i++ )
+		result[i] = f(d1[i], d2[i]);
+}
+
+#ifdef EXPR_ARRAYS_X86
+
+static bool avx2() {
+
+	return expr::kernels::isa() >= expr::kernels::ISA_AVX2;
+}
+
+// vsqrtpd, vroundpd are correctly rounded like sqrt, floor and ceil of libm
+template <int mode>
+__attribute__((target("avx2")))
+static void rounded_avx2(const double *d, double *r, const size_t n) {
+
+	size_t i = 0;
+	int negative = 0;
+
+	for ( ; i + 4 <= n; i += 4 ) {
+
+		__m256d x = _mm256_loadu_pd(d + i);
+
+		if constexpr ( mode == 0 ) {
+			negative |= _mm256_movemask_pd(_mm256_cmp_pd(x, _mm256_setzero_pd(), _CMP_LT_OQ));
+			_mm256_storeu_pd(r + i, _mm256_sqrt_pd(x));
+			continue;
+		}
+
+		// libm returns nan as it is, vroundpd quiets signaling nan
+		__m256d n = _mm256_cmp_pd(x, x, _CMP_UNORD_Q);
+		__m256d y = mode == 1 ? _mm256_floor_pd(x) : _mm256_ceil_pd(x);
+		_mm256_storeu_pd(r + i, _mm256_blendv_pd(y, x, n));
+	}
+
+	// sqrt of libm sets errno for negative arguments
+	if ( mode == 0 && negative != 0 && math_errhandling & MATH_ERRNO )
+		errno = EDOM;
+
+	for ( ; i < n; i++ )
+		r[i] = mode == 0 ? std::sqrt(d[i]) : ( mode == 1 ? std::floor(d[i]) : std::ceil(d[i]));
+}
+
+#endif
+
+#ifdef EXPR_ARRAYS_MVEC
+
+#pragma GCC push_options
+#pragma GCC target("avx2")
+
+// vector math library of glibc, avx2 variants
+extern "C" {
+	__m256d _ZGVdN4v_sin(__m256d x);
+	__m256d _ZGVdN4v_cos(__m256d x);
+	__m256d _ZGVdN4v_tan(__m256d x);
+	__m256d _ZGVdN4v_exp(__m256d x);
+	__m256d _ZGVdN4v_log(__m256d x);
+	__m256d _ZGVdN4v_log10(__m256d x);
+	__m256d _ZGVdN4vv_pow(__m256d x, __m256d y);
+}
+
+// lanes where result is not a normal number, they are the ones
+// where libm may set errno
+static int irregular(const __m256d r) {
+
+	__m256d a = _mm256_andnot_pd(_mm256_set1_pd(-0.0), r);
+	__m256d normal = _mm256_and_pd(_mm256_cmp_pd(a, _mm256_set1_pd(DBL_MIN), _CMP_GE_OQ),
+		_mm256_cmp_pd(a, _mm256_set1_pd(DBL_MAX), _CMP_LE_OQ));
+
+	return ~_mm256_movemask_pd(normal) & 0xf;
+}
+
+// rows after last row are ones, so every row gets same approximation.
+// Irregular rows are applied again with scalar function, which sets
+// errno like row by row evaluation does
+template <__m256d (*F)(__m256d), double (*S)(double)>
+static void mvec(std::span<const double> d, std::span<double> result) {
+
+	for ( size_t i = 0; i < result.size(); i += 4 ) {
+
+		size_t n = std::min((size_t)4, result.size() - i);
+		__m256d x = _mm256_set1_pd(1.0);
+
+		std::memcpy(&x, d.data() + i, n * sizeof(double));
+		x = F(x);
+		std::memcpy(result.data() + i, &x, n * sizeof(double));
+
+		for ( int m = irregular(x) & (( 1 << n ) - 1 ), j = 0; m != 0; m >>= 1, j++ )
+			if ( m & 1 )
+				result[i + j] = S(d[i + j]);
+	}
+}
+
+template <__m256d (*F)(__m256d, __m256d), double (*S)(double, double)>
+static void mvec(std::span<const double> d1, std::span<const double> d2, std::span<double> result) {
+
+	for ( size_t i = 0; i < result.size(); i += 4 ) {
+
+		size_t n = std::min((size_t)4, result.size() - i);
+		__m256d x = _mm256_set1_pd(1.0);
+		__m256d y = x;
+
+		std::memcpy(&x, d1.data() + i, n * sizeof(double));
+		std::memcpy(&y, d2.data() + i, n * sizeof(double));
+		x = F(x, y);
+		std::memcpy(result.data() + i, &x, n * sizeof(double));
+
+		for ( int m = irregular(x) & (( 1 << n ) - 1 ), j = 0; m != 0; m >>= 1, j++ )
+			if ( m & 1 )
+				result[i + j] = S(d1[i + j], d2[i + j]);
+	}
+}
+
+#pragma GCC pop_options
+
+#endif
+
+void expr::functions::arrays::sqrt(std::span<const double> d, std::span<double> result) {
+
+#ifdef EXPR_ARRAYS_X86
+	if ( avx2())
+		return rounded_avx2<0>(d.data(), result.data(), result.size());
+#endif
+	each(d, result, expr::functions::sqrt);
+}
+
+void expr::functions::arrays::exp(std::span<const double> d, std::span<double> result) {
+
+#ifdef EXPR_ARRAYS_MVEC
+	if ( avx2())
+		return mvec<_ZGVdN4v_exp, expr::functions::exp>(d, result);
+#endif
+	each(d, result, expr::functions::exp);
+}
+
+void expr::functions::arrays::ln(std::span<const double> d, std::span<double> result) {
+
+#ifdef EXPR_ARRAYS_MVEC
+	if ( avx2())
+		return mvec<_ZGVdN4v_log, expr::functions::ln>(d, result);
+#endif
+	each(d, result, expr::functions::ln);
+}
+
+void expr::functions::arrays::log(std::span<const double> d, std::span<double> result) {
+
+#ifdef EXPR_ARRAYS_MVEC
+	if ( avx2())
+		return mvec<_ZGVdN4v_log10, expr::functions::log>(d, result);
+#endif
+	each(d, result, expr::functions::log);
+}
+
+void expr::functions::arrays::sin(std::span<const double> d, std::span<double> result) {
+
+#ifdef EXPR_ARRAYS_MVEC
+	if ( avx2())
+		return mvec<_ZGVdN4v_sin, expr::functions::sin>(d, result);
+#endif
+	each(d, result, expr::functions::sin);
+}
+
+void expr::functions::arrays::cos(std::span<const double> d, std::span<double> result) {
+
+#ifdef EXPR_ARRAYS_MVEC
+	if ( avx2())
+		return mvec<_ZGVdN4v_cos, expr::functions::cos>(d, result);
+#endif
+	each(d, result, expr::functions::cos);
+}
+
+void expr::functions::arrays::tan(std::span<const double> d, std::span<double> result) {
+
+#ifdef EXPR_ARRAYS_MVEC
+	if ( avx2())
+		return mvec<_ZGVdN4v_tan, expr::functions::tan>(d, result);
+#endif
+	each(d, result, expr::functions::tan);
+}
+
+void expr::functions::arrays::min(std::span<const double> d1, std::span<const double> d2, std::span<double> result) {
+
+	each(d1, d2, result, expr::functions::min);
+}
+
+void expr::functions::arrays::max(std::span<const double> d1, std::span<const double> d2, std::span<double> result) {
+
+	each(d1, d2, result, expr::functions::max);
+}
+
+void expr::functions::arrays::floor(std::span<const double> d, std::span<double> result) {
+
+#ifdef EXPR_ARRAYS_X86
+	if ( avx2())
+		return rounded_avx2<1>(d.data(), result.data(), result.size());
+#endif
+	each(d, result, expr::functions::floor);
+}
+
+void expr::functions::arrays::ceil(std::span<const double> d, std::span<double> result) {
+
+#ifdef EXPR_ARRAYS_X86
+	if ( avx2())
+		return rounded_avx2<2>(d.data(), result.data(), result.size());
+#endif
+	each(d, result, expr::functions::ceil);
+}
+
+void expr::functions::arrays::round(std::span<const double> d, std::span<double> result) {
+
+	each(d, result, expr::functions::round);
 }
 
-expr::VARIABLE expr::functions::strlen(const expr::FUNCTION_ARGS& args) {
+void expr::functions::arrays::pow(std::span<const double> d1, std::span<const double> d2, std::span<double> result) {
 
-	if ( args.empty())
+#ifdef EXPR_ARRAYS_MVEC
+	if ( avx2())
+		return mvec<_ZGVdN4vv_pow, power>(d1, d2, result);
+#endif
+	each(d1, d2, result, power);
+}
+
+double expr::functions::strlen(const expr::VARIABLE& v) {
+
+	if ( const std::string *s = std::get_if<std::string>(&v))
+		return (double)s -> size();
+	else if ( v.is_null())
 		return (double)0;
-	else return (double)args[0].to_string().size();
+	else return (double)v.to_string().size();
 }
 
-expr::VARIABLE expr::functions::to_upper(const expr::FUNCTION_ARGS& args) {
+std::string expr::functions::to_upper(const std::string& s) {
 
-	if ( args.empty())
-		return "";
-	else if ( args[0].to_string().empty())
-		return "";
-	else return common::to_upper(args[0].to_string());
+	return s.empty() ? "" : common::to_upper(s);
 }
 
-expr::VARIABLE expr::functions::to_lower(const expr::FUNCTION_ARGS& args) {
+std::string expr::functions::to_lower(const std::string& s) {
 
-	if ( args.empty())
-		return "";
-	else if ( args[0].to_string().empty())
-		return "";
-	else return common::to_lower(args[0].to_string());
+	return s.empty() ? "" : common::to_lower(s);
 }
 
-expr::VARIABLE expr::functions::substr(const expr::FUNCTION_ARGS& args) {
+expr::VARIABLE expr::functions::substr(expr::FUNCTION_ARGS_VIEW args) {
 
 	if ( args.empty() || args.size() < 2 ) {
 
@@ -382,51 +702,57 @@ expr::VARIABLE expr::functions::substr(const expr::FUNCTION_ARGS& args) {
 
 expr::FUNCTIONMAP expr::functions::builtin_functions = {
 
-	{ "time", expr::functions::time_unixtime },
-	{ "time::timestamp", expr::functions::time_unixtime },
-	{ "time::unixtime", expr::functions::time_unixtime },
-
-	{ "time::hour", expr::functions::time_hour },
-	{ "time::min", expr::functions::time_min },
-	{ "time::sec", expr::functions::time_sec },
-
-	{ "date::day", expr::functions::date_day },
-	{ "date::month", expr::functions::date_month },
-	{ "date::year", expr::functions::date_year },
-	{ "date::weekday", expr::functions::date_weekday },
-	{ "date::day::name", expr::functions::date_day_name },
-
-	{ "strftime", expr::functions::strftime },
-	{ "put_time", expr::functions::strftime },
-
-	{ "to_string", expr::functions::to_string },
-	{ "to_double", expr::functions::to_double },
-	{ "to_int", expr::functions::to_int },
-	{ "to_number", expr::functions::to_double },
-	{ "to_bool", expr::functions::to_bool },
-
-	{ "is_odd", expr::functions::is_odd },
-	{ "is_even", expr::functions::is_even },
-
-	{ "sqrt", expr::functions::sqrt },
-	{ "exp", expr::functions::exp },
-	{ "ln", expr::functions::ln },
-	{ "log", expr::functions::log },
-	{ "sin", expr::functions::sin },
-	{ "cos", expr::functions::cos },
-	{ "tan", expr::functions::tan },
-	{ "min", expr::functions::min },
-	{ "max", expr::functions::max },
-	{ "floor", expr::functions::floor },
-	{ "ceil", expr::functions::ceil },
-	{ "round", expr::functions::round },
-
-	{ "strlen", expr::functions::strlen },
-	{ "length", expr::functions::strlen },
-	{ "to_upper", expr::functions::to_upper },
-	{ "strupper", expr::functions::to_upper },
-	{ "to_lower", expr::functions::to_lower },
-	{ "strlower", expr::functions::to_lower },
-	{ "substr", expr::functions::substr },
+	{ "time", expr::per_tick(expr::typed<double()>(expr::functions::time_unixtime)) },
+	{ "time::timestamp", expr::per_tick(expr::typed<double()>(expr::functions::time_unixtime)) },
+	{ "time::unixtime", expr::per_tick(expr::typed<double()>(expr::functions::time_unixtime)) },
+
+	{ "time::hour", expr::per_tick(expr::typed<double()>(expr::functions::time_hour)) },
+	{ "time::min", expr::per_tick(expr::typed<double()>(expr::functions::time_min)) },
+	{ "time::sec", expr::per_tick(expr::typed<double()>(expr::functions::time_sec)) },
+
+	{ "date::day", expr::per_tick(expr::typed<double()>(expr::functions::date_day)) },
+	{ "date::month", expr::per_tick(expr::typed<double()>(expr::functions::date_month)) },
+	{ "date::year", expr::per_tick(expr::typed<double()>(expr::functions::date_year)) },
+	{ "date::weekday", expr::per_tick(expr::typed<double()>(expr::functions::date_weekday)) },
+	{ "date::day::name", expr::per_tick(expr::typed<std::string()>(expr::functions::date_day_name)) },
+
+	{ "strftime", expr::per_tick(expr::functions::strftime) },
+	{ "put_time", expr::per_tick(expr::functions::strftime) },
+
+	{ "to_string", expr::pure(expr::typed<std::string(const expr::VARIABLE&)>(expr::functions::to_string)) },
+	{ "to_double", expr::pure(expr::typed<double(double)>(expr::functions::to_double)) },
+	{ "to_int", expr::pure(expr::typed<double(double)>(expr::functions::to_int)) },
+	{ "to_number", expr::pure(expr::typed<double(double)>(expr::functions::to_double)) },
+	{ "to_bool", expr::pure(expr::typed<bool(double)>(expr::functions::to_bool)) },
+
+	{ "is_odd", expr::pure(expr::typed<bool(double)>(expr::functions::is_odd)) },
+	{ "is_even", expr::pure(expr::typed<bool(double)>(expr::functions::is_even)) },
+
+	{ "sqrt", expr::vectorized(expr::pure(expr::typed<double(double)>(expr::functions::sqrt)), expr::functions::arrays::sqrt) },
+	{ "exp", expr::vectorized(expr::pure(expr::typed<double(double)>(expr::functions::exp)), expr::functions::arrays::exp) },
+	{ "ln", expr::vectorized(expr::pure(expr::typed<double(double)>(expr::functions::ln)), expr::functions::arrays::ln) },
+	{ "log", expr::vectorized(expr::pure(expr::typed<double(double)>(expr::functions::log)), expr::functions::arrays::log) },
+	{ "sin", expr::vectorized(expr::pure(expr::typed<double(double)>(expr::functions::sin)), expr::functions::arrays::sin) },
+	{ "cos", expr::vectorized(expr::pure(expr::typed<double(double)>(expr::functions::cos)), expr::functions::arrays::cos) },
+	{ "tan", expr::vectorized(expr::pure(expr::typed<double(double)>(expr::functions::tan)), expr::functions::arrays::tan) },
+	{ "min", expr::vectorized(expr::pure(expr::typed<double(double, double)>(expr::functions::min)), expr::functions::arrays::min) },
+	{ "max", expr::vectorized(expr::pure(expr::typed<double(double, double)>(expr::functions::max)), expr::functions::arrays::max) },
+	{ "floor", expr::vectorized(expr::pure(expr::typed<double(double)>(expr::functions::floor)), expr::functions::arrays::floor) },
+	{ "ceil", expr::vectorized(expr::pure(expr::typed<double(double)>(expr::functions::ceil)), expr::functions::arrays::ceil) },
+	{ "round", expr::vectorized(expr::pure(expr::typed<double(double)>(expr::functions::round)), expr::functions::arrays::round) },
+
+	{ "strlen", expr::pure(expr::typed<double(const expr::VARIABLE&)>(expr::functions::strlen)) },
+	{ "length", expr::pure(expr::typed<double(const expr::VARIABLE&)>(expr::functions::strlen)) },
+	{ "to_upper", expr::pure(expr::typed<std::string(const std::string&)>(expr::functions::to_upper)) },
+	{ "strupper", expr::pure(expr::typed<std::string(const std::string&)>(expr::functions::to_upper)) },
+	{ "to_lower", expr::pure(expr::typed<std::string(const std::string&)>(expr::functions::to_lower)) },
+	{ "strlower", expr::pure(expr::typed<std::string(const std::string&)>(expr::functions::to_lower)) },
+	{ "substr", expr::pure(expr::functions::substr) },
 
 };
+
+const bool expr::functions::is_pure(const std::string& name) {
+
+	auto it = expr::functions::builtin_functions.find(name);
+	return it != expr::functions::builtin_functions.end() && it -> second.purity() == expr::F_PURE;
+}
@@ -0,0 +1,395 @@
+#include <cmath>
+#include <cerrno>
+#include <cfenv>
+#include <atomic>
+#include <cstring>
+#include <cstdint>
+#include <algorithm>
+#include "expr/ops.hpp"
+#include "expr/kernels.hpp"
+
+#if defined(__GNUC__) && ( defined(__x86_64__) || defined(__i386__))
+#define EXPR_KERNELS_X86
+#include <immintrin.h>
+#endif
+
+#define KERNEL inline __attribute__((always_inline))
+
+// vectors of compiler, lanes of comparisons are masks of all bits
+typedef double V2 __attribute__((vector_size(16)));
+typedef int64_t M2 __attribute__((vector_size(16)));
+typedef double V4 __attribute__((vector_size(32)));
+typedef int64_t M4 __attribute__((vector_size(32)));
+typedef double V8 __attribute__((vector_size(64)));
+typedef int64_t M8 __attribute__((vector_size(64)));
+
+// rows of division that are tested for math errors at once
+static constexpr size_t BLOCK = 256;
+
+struct TABLE {
+
+	void (*binary)(const expr::OP op, double *r, const double *a, const double *b, const size_t n);
+	void (*unary)(const expr::OP op, double *r, const double *a, const size_t n);
+	bool (*quotients)(double *q, const double *a, const double *b, const size_t n);
+};
+
+// operator applied to lanes, with same comparisons and results as expr::ops
+template <typename V, typename M, expr::OP op, bool unary>
+static KERNEL void lanes(const V& x, const V& y, V& z) {
+
+	const V zero = {};
+	const M one = (M)(zero + 1.0);
+
+	if constexpr ( unary && op == expr::OP_SUB ) z = -x;
+	else if constexpr ( unary && op == expr::OP_NOT ) z = (V)(one & ( x == zero ));
+	else if constexpr ( unary && op == expr::OP_NNOT ) z = (V)(one & ( x != zero ));
+	else if constexpr ( op == expr::OP_ADD ) z = x + y;
+	else if constexpr ( op == expr::OP_SUB ) z = x - y;
+	else if constexpr ( op == expr::OP_MUL ) z = x * y;
+	else if constexpr ( op == expr::OP_OR ) z = (V)(one & (( x != zero ) | ( y != zero )));
+	else if constexpr ( op == expr::OP_AND ) z = (V)(one & (( x != zero ) & ( y != zero )));
+	else if constexpr ( op == expr::OP_NEQ ) z = (V)(one & ( x == y ));
+	else if constexpr ( op == expr::OP_NNE ) z = (V)(one & ( x != y ));
+	else if constexpr ( op == expr::OP_NLT ) z = (V)(one & ( x < y ));
+	else if constexpr ( op == expr::OP_NLE ) z = (V)(one & ( x <= y ));
+	else if constexpr ( op == expr::OP_NGT ) z = (V)(one & ( x > y ));
+	else if constexpr ( op == expr::OP_NGE ) z = (V)(one & ( x >= y ));
+}
+
+template <typename V, typename M, expr::OP op, bool unary>
+static KERNEL void loop(double *r, const double *a, const double *b, const size_t n) {
+
+	constexpr size_t W = sizeof(V) / sizeof(double);
+	size_t i = 0;
+	V x, y, z;
+
+	for ( ; i + W <= n; i += W ) {
+		std::memcpy(&x, a + i, sizeof(V));
+		std::memcpy(&y, b + i, sizeof(V));
+		lanes<V, M, op, unary>(x, y, z);
+		std::memcpy(r + i, &z, sizeof(V));
+	}
+
+	if ( i < n ) {
+		x = V{} + 1.0;
+		y = x;
+		std::memcpy(&x, a + i, ( n - i ) * sizeof(double));
+		std::memcpy(&y, b + i, ( n - i ) * sizeof(double));
+		lanes<V, M, op, unary>(x, y, z);
+		std::memcpy(r + i, &z, ( n - i ) * sizeof(double));
+	}
+}
+
+template <typename V, typename M>
+static KERNEL void binary(const expr::OP op, double *r, const double *a, const double *b, const size_t n) {
+
+	switch ( op ) {
+		case expr::OP_ADD: loop<V, M, expr::OP_ADD, false>(r, a, b, n); break;
+		case expr::OP_SUB: loop<V, M, expr::OP_SUB, false>(r, a, b, n); break;
+		case expr::OP_MUL: loop<V, M, expr::OP_MUL, false>(r, a, b, n); break;
+		case expr::OP_OR2:
+		case expr::OP_OR: loop<V, M, expr::OP_OR, false>(r, a, b, n); break;
+		case expr::OP_AND2:
+		case expr::OP_AND: loop<V, M, expr::OP_AND, false>(r, a, b, n); break;
+		case expr::OP_NEQ: loop<V, M, expr::OP_NEQ, false>(r, a, b, n); break;
+		case expr::OP_NNE: loop<V, M, expr::OP_NNE, false>(r, a, b, n); break;
+		case expr::OP_NLT: loop<V, M, expr::OP_NLT, false>(r, a, b, n); break;
+		case expr::OP_NLE: loop<V, M, expr::OP_NLE, false>(r, a, b, n); break;
+		case expr::OP_NGT: loop<V, M, expr::OP_NGT, false>(r, a, b, n); break;
+		case expr::OP_NGE: loop<V, M, expr::OP_NGE, false>(r, a, b, n); break;
+		default: break;
+	}
+}
+
+template <typename V, typename M>
+static KERNEL void unary(const expr::OP op, double *r, const double *a, const size_t n) {
+
+	switch ( op ) {
+		case expr::OP_SUB: loop<V, M, expr::OP_SUB, true>(r, a, a, n); break;
+		case expr::OP_NOT: loop<V, M, expr::OP_NOT, true>(r, a, a, n); break;
+		case expr::OP_NNOT: loop<V, M, expr::OP_NNOT, true>(r, a, a, n); break;
+		default: break;
+	}
+}
+
+// quotients of rows to q, true when an operand is zero and
+// expr::ops::DIV does not divide
+template <typename V, typename M>
+static KERNEL bool quotients(double *q, const double *a, const double *b, const size_t n) {
+
+	constexpr size_t W = sizeof(V) / sizeof(double);
+	const V zero = {};
+	size_t i = 0;
+	M zeros = {};
+	V x, y, z;
+
+	for ( ; i + W <= n; i += W ) {
+		std::memcpy(&x, a + i, sizeof(V));
+		std::memcpy(&y, b + i, sizeof(V));
+		zeros |= ( x == zero ) | ( y == zero );
+		z = x / y;
+		std::memcpy(q + i, &z, sizeof(V));
+	}
+
+	if ( i < n ) {
+		x = zero + 1.0;
+		y = x;
+		std::memcpy(&x, a + i, ( n - i ) * sizeof(double));
+		std::memcpy(&y, b + i, ( n - i ) * sizeof(double));
+		zeros |= ( x == zero ) | ( y == zero );
+		z = x / y;
+		std::memcpy(q + i, &z, ( n - i ) * sizeof(double));
+	}
+
+	for ( size_t l = 0; l < W; l++ )
+		if ( zeros[l] != 0 )
+			return true;
+
+	return false;
+}
+
+static void binary_generic(const expr::OP op, double *r, const double *a, const double *b, const size_t n) { binary<V2, M2>(op, r, a, b, n); }
+static void unary_generic(const expr::OP op, double *r, const double *a, const size_t n) { unary<V2, M2>(op, r, a, n); }
+static bool quotients_generic(double *q, const double *a, const double *b, const size_t n) { return quotients<V2, M2>(q, a, b, n); }
+
+#ifdef EXPR_KERNELS_X86
+
+__attribute__((target("sse2")))
+static void binary_sse2(const expr::OP op, double *r, const double *a, const double *b, const size_t n) { binary<V2, M2>(op, r, a, b, n); }
+__attribute__((target("sse2")))
+static void unary_sse2(const expr::OP op, double *r, const double *a, const size_t n) { unary<V2, M2>(op, r, a, n); }
+__attribute__((target("sse2")))
+static bool quotients_sse2(double *q, const double *a, const double *b, const size_t n) { return quotients<V2, M2>(q, a, b, n); }
+
+__attribute__((target("avx2")))
+static void binary_avx2(const expr::OP op, double *r, const double *a, const double *b, const size_t n) { binary<V4, M4>(op, r, a, b, n); }
+__attribute__((target("avx2")))
+static void unary_avx2(const expr::OP op, double *r, const double *a, const size_t n) { unary<V4, M4>(op, r, a, n); }
+__attribute__((target("avx2")))
+static bool quotients_avx2(double *q, const double *a, const double *b, const size_t n) { return quotients<V4, M4>(q, a, b, n); }
+
+// comparisons of avx512 are to mask registers; compiler does not keep them
+// there when they are combined, so || && and zero tests use intrinsics
+__attribute__((target("avx512f")))
+static void logical_avx512(const bool conjunction, double *r, const double *a, const double *b, const size_t n) {
+
+	const __m512d zero = _mm512_setzero_pd();
+	const __m512d one = _mm512_set1_pd(1.0);
+
+	for ( size_t i = 0; i < n; i += 8 ) {
+
+		__mmask8 rows = n - i < 8 ? (__mmask8)(( 1u << ( n - i )) - 1 ) : (__mmask8)0xff;
+		__mmask8 x = _mm512_cmp_pd_mask(_mm512_maskz_loadu_pd(rows, a + i), zero, _CMP_NEQ_UQ);
+		__mmask8 y = _mm512_cmp_pd_mask(_mm512_maskz_loadu_pd(rows, b + i), zero, _CMP_NEQ_UQ);
+		_mm512_mask_storeu_pd(r + i, rows, _mm512_maskz_mov_pd(conjunction ? x & y : x | y, one));
+	}
+}
+
+__attribute__((target("avx512f")))
+static void binary_avx512(const expr::OP op, double *r, const double *a, const double *b, const size_t n) {
+
+	if ( op == expr::OP_OR || op == expr::OP_OR2 || op == expr::OP_AND || op == expr::OP_AND2 )
+		logical_avx512(op == expr::OP_AND || op == expr::OP_AND2, r, a, b, n);
+	else binary<V8, M8>(op, r, a, b, n);
+}
+
+__attribute__((target("avx512f")))
+static void unary_avx512(const expr::OP op, double *r, const double *a, const size_t n) { unary<V8, M8>(op, r, a, n); }
+
+__attribute__((target("avx512f")))
+static bool quotients_avx512(double *q, const double *a, const double *b, const size_t n) {
+
+	const __m512d zero = _mm512_setzero_pd();
+	const __m512d one = _mm512_set1_pd(1.0);
+	__mmask8 zeros = 0;
+
+	// rows after last row are ones, they raise no math errors
+	for ( size_t i = 0; i < n; i += 8 ) {
+
+		__mmask8 rows = n - i < 8 ? (__mmask8)(( 1u << ( n - i )) - 1 ) : (__mmask8)0xff;
+		__m512d x = _mm512_mask_loadu_pd(one, rows, a + i);
+		__m512d y = _mm512_mask_loadu_pd(one, rows, b + i);
+		zeros |= _mm512_cmp_pd_mask(x, zero, _CMP_EQ_OQ) | _mm512_cmp_pd_mask(y, zero, _CMP_EQ_OQ);
+		_mm512_mask_storeu_pd(q + i, rows, _mm512_div_pd(x, y));
+	}
+
+	return zeros != 0;
+}
+
+#endif
+
+// kernels of instruction sets, indexed by expr::kernels::ISA
+static const TABLE tables[] = {
+	{ binary_generic, unary_generic, quotients_generic },
+#ifdef EXPR_KERNELS_X86
+	{ binary_sse2, unary_sse2, quotients_sse2 },
+	{ binary_avx2, unary_avx2, quotients_avx2 },
+	{ binary_avx512, unary_avx512, quotients_avx512 },
+#else
+	{ binary_generic, unary_generic, quotients_generic },
+	{ binary_generic, unary_generic, quotients_generic },
+	{ binary_generic, unary_generic, quotients_generic },
+#endif
+};
+
+static std::atomic<int> selected_isa = -1;
+
+static const TABLE& table() {
+
+	int isa = selected_isa.load(std::memory_order_relaxed);
+
+	if ( isa == -1 ) {
+
+		isa = expr::kernels::ISA_GENERIC;
+
+		for ( int i : { expr::kernels::ISA_AVX512, expr::kernels::ISA_AVX2, expr::kernels::ISA_SSE2 })
+			if ( expr::kernels::supported((expr::kernels::ISA)i)) {
+				isa = i;
+				break;
+			}
+
+		selected_isa.store(isa, std::memory_order_relaxed);
+	}
+
+	return tables[isa];
+}
+
+// math errors that make expr::ops::DIV and expr::ops::MOD return 0
+static bool math_error() {
+
+	if ( math_errhandling & MATH_ERRNO && ( errno == EDOM || errno == ERANGE ))
+		return true;
+
+	return math_errhandling & MATH_ERREXCEPT &&
+		fetestexcept(FE_INVALID | FE_DIVBYZERO | FE_OVERFLOW | FE_UNDERFLOW);
+}
+
+// rows of block are divided with math errors cleared once; when an operand
+// is zero or an error was raised, rows of block are divided again one by one
+// with expr::ops, so results and warnings are those of scalar evaluation
+static void divide(double *r, const double *a, const double *b, const size_t n, const bool modulo) {
+
+	double q[BLOCK];
+
+	for ( size_t i = 0; i < n; i += BLOCK ) {
+
+		size_t m = std::min(BLOCK, n - i);
+		int saved = errno;
+		bool special = math_error();
+
+		if ( !special ) {
+
+			if ( math_errhandling & MATH_ERREXCEPT ) feclearexcept(FE_ALL_EXCEPT);
+
+			if ( modulo )
+				for ( size_t j = 0; j < m; j++ ) {
+					special |= b[i + j] == 0;
+					q[j] = std::fmod(a[i + j], b[i + j]);
+				}
+			else special = table().quotients(q, a + i, b + i, m);
+
+			special = special || math_error();
+		}
+
+		if ( !special ) {
+			std::copy(q, q + m, r + i);
+			continue;
+		}
+
+		errno = saved;
+
+		for ( size_t j = i; j < i + m; j++ )
+			r[j] = modulo ? expr::ops::MOD(a[j], b[j]) : expr::ops::DIV(a[j], b[j]);
+	}
+}
+
+const expr::kernels::ISA expr::kernels::isa() {
+
+	table();
+	return (expr::kernels::ISA)selected_isa.load(std::memory_order_relaxed);
+}
+
+const bool expr::kernels::supported(const expr::kernels::ISA isa) {
+
+	switch ( isa ) {
+		case expr::kernels::ISA_GENERIC: return true;
+#ifdef EXPR_KERNELS_X86
+		case expr::kernels::ISA_SSE2: return __builtin_cpu_supports("sse2");
+		case expr::kernels::ISA_AVX2: return __builtin_cpu_supports("avx2");
+		case expr::kernels::ISA_AVX512: return __builtin_cpu_supports("avx512f");
+#endif
+		default: return false;
+	}
+}
+
+const bool expr::kernels::select(const expr::kernels::ISA isa) {
+
+	if ( !expr::kernels::supported(isa))
+		return false;
+
+	selected_isa.store(isa, std::memory_order_relaxed);
+	return true;
+}
+
+const bool expr::kernels::is_binary(const expr::OP op) {
+
+	switch ( op ) {
+		case expr::OP_ADD: case expr::OP_SUB: case expr::OP_MUL: case expr::OP_DIV:
+		case expr::OP_MOD: case expr::OP_POW: case expr::OP_OR2: case expr::OP_OR:
+		case expr::OP_AND2: case expr::OP_AND: case expr::OP_NEQ: case expr::OP_NNE:
+		case expr::OP_NLT: case expr::OP_NLE: case expr::OP_NGT: case expr::OP_NGE:
+			return true;
+		default:
+			return false;
+	}
+}
+
+const bool expr::kernels::is_unary(const expr::OP op) {
+
+	return op == expr::OP_SUB || op == expr::OP_NOT || op == expr::OP_NNOT;
+}
+
+const bool expr::kernels::binary(const expr::OP op, std::span<const double> a, std::span<const double> b, std::span<double> result) {
+
+	const size_t n = result.size();
+
+	switch ( op ) {
+		case expr::OP_DIV:
+			divide(result.data(), a.data(), b.data(), n, false);
+			return true;
+		case expr::OP_MOD:
+			divide(result.data(), a.data(), b.data(), n, true);
+			return true;
+		case expr::OP_POW:
+			for ( size_t i = 0; i < n; i++ )
+				result[i] = expr::ops::POW(a[i], b[i]);
+			return true;
+		default:
+			if ( !expr::kernels::is_binary(op))
+				return false;
+
+			table().binary(op, result.data(), a.data(), b.data(), n);
+			return true;
+	}
+}
+
+const bool expr::kernels::unary(const expr::OP op, std::span<const double> a, std::span<double> result) {
+
+	if ( !expr::kernels::is_unary(op))
+		return false;
+
+	table().unary(op, result.data(), a.data(), result.size());
+	return true;
+}
+
+const std::string describe(const expr::kernels::ISA& isa) {
+
+	switch ( isa ) {
+		case expr::kernels::ISA_GENERIC: return "generic";
+		case expr::kernels::ISA_SSE2: return "sse2";
+		case expr::kernels::ISA_AVX2: return "avx2";
+		case expr::kernels::ISA_AVX512: return "avx512";
+	}
+
+	return "unknown";
+}
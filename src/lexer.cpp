@@ -0,0 +1,384 @@
+#include <cctype>
+#include <charconv>
+#include <tsl/ordered_map.h>
+#include "logger.hpp"
+#include "expr/lexer.hpp"
+
+// important note: longest operator patterns in the beginning, shortest in the end
+static tsl::ordered_map<std::string, expr::OP> Pattern1 = {
+	{ "==", expr::OP_NEQ },
+	{ "!=", expr::OP_NNE },
+	{ "<=", expr::OP_NLE },
+	{ "=<", expr::OP_NLE },
+	{ ">=", expr::OP_NGE },
+	{ "=>", expr::OP_NGE },
+	{ "&&", expr::OP_AND2 },
+	{ "||", expr::OP_OR2 },
+	{ "<", expr::OP_NLT },
+	{ ">", expr::OP_NGT },
+	{ "|", expr::OP_OR },
+	{ "&", expr::OP_AND },
+	{ "!", expr::OP_NOT },
+	{ "+", expr::OP_ADD },
+	{ "-", expr::OP_SUB },
+	{ ".", expr::OP_CAT },
+	{ "*", expr::OP_MUL },
+	{ "/", expr::OP_DIV },
+	{ ",", expr::OP_COM },
+	{ "%", expr::OP_MOD },
+	{ "^", expr::OP_POW },
+	{ "=", expr::OP_SET },
+};
+
+// important note: longest operator patterns in the beginning, shortest in the end
+static tsl::ordered_map<std::string, expr::OP> Pattern2 = {
+	{ "eq", expr::OP_SEQ },
+	{ "ne", expr::OP_SNE },
+	{ "lt", expr::OP_SLT },
+	{ "le", expr::OP_SLE },
+	{ "gt", expr::OP_SGT },
+	{ "ge", expr::OP_SGE }
+};
+
+// colon is unsupported as a starting character of a word, but it is
+// a part of conditional syntax and names such as date::day
+static std::string_view unsupported_characters = "#$¢€:;@[]_\\";
+
+static bool is_space(const char c) {
+	return std::isspace((unsigned char)c);
+}
+
+static bool is_digit(const char c) {
+	return c >= '0' && c <= '9';
+}
+
+static bool is_alpha(const char c) {
+	return std::isalpha((unsigned char)c);
+}
+
+static bool is_alnum(const char c) {
+	return is_alpha(c) || is_digit(c);
+}
+
+static bool is_unsupported(const char c) {
+	return c != ':' && unsupported_characters.find(c) != std::string_view::npos;
+}
+
+expr::lexer::lexer(std::string_view src) {
+
+	this -> _src = src;
+	this -> _pos = 0;
+	this -> _peeked = false;
+}
+
+const std::string_view expr::lexer::source() const {
+	return this -> _src;
+}
+
+const size_t expr::lexer::position() const {
+	return this -> _peeked ? this -> _next.offset : this -> _pos;
+}
+
+const std::string_view expr::lexer::text(const expr::LEXEME& l) const {
+	return this -> _src.substr(l.offset, l.length);
+}
+
+const expr::LEXEME expr::lexer::next() {
+
+	if ( this -> _peeked ) {
+		this -> _peeked = false;
+		return this -> _next;
+	}
+
+	return this -> scan();
+}
+
+const expr::LEXEME& expr::lexer::peek() {
+
+	if ( !this -> _peeked ) {
+		this -> _next = this -> scan();
+		this -> _peeked = true;
+	}
+
+	return this -> _next;
+}
+
+expr::LEXEME expr::lexer::scan() {
+
+	const std::string_view& s = this -> _src;
+	size_t& pos = this -> _pos;
+	LEXEME l;
+
+	while ( pos < s.size()) {
+
+		if ( is_space(s[pos])) {
+			l.space = true;
+			pos++;
+			continue;
+		}
+
+		if ( !is_unsupported(s[pos]))
+			break;
+
+		size_t begin = pos;
+
+		while ( pos < s.size() && is_unsupported(s[pos]))
+			pos++;
+
+		logger::warning["parser"] << "ignoring unsupported characters '" << s.substr(begin, pos - begin) <<
+			"' at <" << s << ">" << std::endl;
+	}
+
+	l.offset = pos;
+
+	if ( pos >= s.size()) {
+		l.type = expr::L_END;
+		return l;
+	}
+
+	if ( is_alpha(s[pos])) { /* names */
+
+		pos++;
+
+		while ( pos < s.size()) {
+
+			if ( is_alnum(s[pos]) || is_unsupported(s[pos]))
+				pos++;
+			else if ( s[pos] == ':' && pos + 1 < s.size() && s[pos + 1] == ':' )
+				pos += 2;
+			else break;
+		}
+
+		l.type = expr::L_NAME;
+		l.length = pos - l.offset;
+
+		/* check for alphanumeric operators */
+		for ( const auto& [key, op] : Pattern2 ) {
+
+			if ( s.substr(l.offset, l.length) == key ) {
+				l.type = expr::L_OPERATOR;
+				l.op = op;
+				break;
+			}
+		}
+
+		return l;
+	}
+
+	if ( is_digit(s[pos]) || ( s[pos] == '.' && pos + 1 < s.size() && is_digit(s[pos + 1]))) { /* numbers */
+
+		while ( pos < s.size() && is_digit(s[pos]))
+			pos++;
+
+		if ( pos < s.size() && s[pos] == '.' ) {
+
+			pos++;
+
+			while ( pos < s.size() && is_digit(s[pos]))
+				pos++;
+		}
+
+		l.type = expr::L_NUMBER;
+
+		if ( pos < s.size() && is_alpha(s[pos])) {
+
+			while ( pos < s.size() && is_alnum(s[pos]))
+				pos++;
+
+			l.type = expr::L_NAME;
+		}
+
+		l.length = pos - l.offset;
+		return l;
+	}
+
+	if ( s[pos] == '\'' || s[pos] == '"' ) { /* string */
+
+		char quote = s[pos++];
+
+		l.type = expr::L_STRING;
+		l.offset = pos;
+
+		while ( pos < s.size() && s[pos] != quote ) {
+
+			if ( s[pos] == '\\' ) {
+				l.escaped = true;
+				pos++;
+			}
+
+			if ( pos < s.size())
+				pos++;
+		}
+
+		l.length = pos - l.offset;
+
+		if ( pos < s.size() && s[pos] == quote )
+			pos++;
+		else
+			logger::warning["parser"] << "unterminated string in <" << s << ">" << std::endl;
+
+		return l;
+	}
+
+	l.length = 1;
+
+	switch ( s[pos] ) {
+		case '(':
+			l.type = expr::L_LPAREN;
+			break;
+		case ')':
+			l.type = expr::L_RPAREN;
+			break;
+		case '?':
+			l.type = expr::L_QUESTION;
+			break;
+		case ':':
+			l.type = expr::L_COLON;
+			break;
+		default: /* non-alpha operators */
+
+			l.type = expr::L_UNKNOWN;
+
+			for ( const auto& [key, op] : Pattern1 ) {
+
+				if ( s.substr(pos).starts_with(key)) {
+					l.type = expr::L_OPERATOR;
+					l.op = op;
+					l.length = key.size();
+					break;
+				}
+			}
+	}
+
+	pos += l.length;
+	return l;
+}
+
+const double expr::lexer::number(const expr::LEXEME& l) const {
+
+	std::string_view word = this -> text(l);
+	double d = 0;
+
+	if ( std::from_chars(word.data(), word.data() + word.size(), d).ec != std::errc()) {
+		logger::error["parser"] << "cannot convert '" << word << "' to number" << std::endl;
+		d = 0;
+	}
+
+	return d;
+}
+
+const std::string expr::lexer::string(const expr::LEXEME& l) const {
+
+	std::string_view s = this -> text(l);
+
+	if ( !l.escaped )
+		return std::string(s);
+
+	std::string word;
+	word.reserve(s.size());
+
+	for ( size_t i = 0; i < s.size(); i++ ) {
+
+		if ( s[i] != '\\' || i + 1 >= s.size()) {
+			word += s[i];
+			continue;
+		}
+
+		switch ( s[i + 1] ) {
+			case '\\':
+				word += '\\';
+				i++;
+				break;
+			case '\'':
+			case '"':
+				word += s[i + 1];
+				i++;
+				break;
+			case 'a':
+				word += '\a';
+				i++;
+				break;
+			case 'b':
+				word += '\b';
+				i++;
+				break;
+			case 't':
+				word += '\t';
+				i++;
+				break;
+			case 'n':
+				word += '\n';
+				i++;
+				break;
+			case 'v':
+				word += '\v';
+				i++;
+				break;
+			case 'f':
+				word += '\f';
+				i++;
+				break;
+			case 'r':
+				word += '\r';
+				i++;
+				break;
+			case 'x': {
+					int hex = 0;
+					size_t n = 0;
+
+					for ( ; n < 2 && i + 2 + n < s.size(); n++ ) {
+
+						char c = s[i + 2 + n];
+
+						if ( c >= '0' && c <= '9' )
+							hex = hex * 16 + c - '0';
+						else if ( c >= 'a' && c <= 'f' )
+							hex = hex * 16 + c - 'a' + 10;
+						else if ( c >= 'A' && c <= 'F' )
+							hex = hex * 16 + c - 'A' + 10;
+						else break;
+					}
+
+					if ( n == 0 ) {
+						logger::warning["parser"] <<
+							"Illegal hex sequence '\\x' in <" <<
+							this -> _src << "> keeps unchanged" << std::endl;
+						word += '\\';
+						break;
+					}
+
+					if ( hex == 0 )
+						logger::warning["parser"] <<
+							"Null character(s) in <" << this -> _src << "> will be ignored" << std::endl;
+					else word += (char)hex;
+
+					i += n + 1;
+				}
+				break;
+			case '0':
+			case '1':
+			case '2':
+			case '3':
+				if ( i + 3 < s.size() &&
+					s[i + 2] >= '0' && s[i + 2] <= '7' &&
+					s[i + 3] >= '0' && s[i + 3] <= '7' ) {
+
+					word += (char)(( s[i + 1] - '0' ) * 64 + ( s[i + 2] - '0' ) * 8 + ( s[i + 3] - '0' ));
+					i += 3;
+				} else {
+					logger::warning["parser"] <<
+						"illegal octal sequence '\\" << s.substr(i + 1, 3) <<
+						"' in <" << this -> _src << ">" << std::endl;
+					word += '\\';
+				}
+				break;
+			default:
+				logger::warning["parser"] <<
+					"unknown escape sequence '\\" << s[i + 1] <<
+					"' in <" << this -> _src << ">" << std::endl;
+				word += '\\';
+		}
+	}
+
+	return word;
+}
@@ -0,0 +1,149 @@
+#include <cstring>
+#include <functional>
+#include <string_view>
+#include "expr/context.hpp"
+#include "expr/function.hpp"
+#include "expr/memo.hpp"
+
+static uint64_t bits(const double d) {
+
+	uint64_t b;
+	std::memcpy(&b, &d, sizeof(double));
+	return b;
+}
+
+static uint64_t mix(const uint64_t h, const uint64_t v) {
+
+	return h ^ ( v + 0x9E3779B97F4A7C15 + ( h << 6 ) + ( h >> 2 ));
+}
+
+// numbers are same when their bits are same, 0 and -0 differ
+static bool same(const expr::context& ctx, const expr::VARIABLE& v, const expr::value arg) {
+
+	if ( arg.is_number()) {
+		const double *d = std::get_if<double>(&v);
+		return d != nullptr && bits(*d) == bits(arg.number());
+	} else if ( arg.is_string()) {
+		const std::string *s = std::get_if<std::string>(&v);
+		return s != nullptr && *s == ctx.string(arg.string());
+	}
+
+	return v.is_null();
+}
+
+// string storage of v is reused
+static void assign(const expr::context& ctx, expr::VARIABLE& v, const expr::value arg) {
+
+	if ( arg.is_number())
+		v.emplace<double>(arg.number());
+	else if ( !arg.is_string())
+		v.emplace<std::nullptr_t>(nullptr);
+	else if ( std::string *s = std::get_if<std::string>(&v))
+		s -> assign(ctx.string(arg.string()));
+	else v.emplace<std::string>(ctx.string(arg.string()));
+}
+
+expr::memo::memo(const size_t capacity) {
+
+	this -> resize(capacity);
+}
+
+expr::memo::ENTRY* expr::memo::entry(const expr::context& ctx, const uint64_t site, const expr::FUNCTION *f, const expr::value *argv, const size_t argc) {
+
+	uint64_t h = mix(site, f -> generation());
+
+	for ( size_t i = 0; i < argc; i++ ) {
+
+		if ( argv[i].is_number())
+			h = mix(h, bits(argv[i].number()));
+		else if ( argv[i].is_string())
+			h = mix(h, std::hash<std::string_view>{}(ctx.string(argv[i].string())));
+		else h = mix(h, 0);
+	}
+
+	h ^= h >> 33;
+	h *= 0xFF51AFD7ED558CCD;
+	h ^= h >> 33;
+
+	return &this -> _entries[h & ( this -> _entries.size() - 1 )];
+}
+
+const expr::VARIABLE* expr::memo::find(const expr::context& ctx, const uint64_t site, const expr::FUNCTION *f, const uint64_t tick, const expr::value *argv, const size_t argc) {
+
+	if ( argc <= expr::memo::MAX_ARGS && !this -> _entries.empty()) {
+
+		ENTRY *e = this -> entry(ctx, site, f, argv, argc);
+
+		if ( e -> site == site && e -> function == f -> generation() && e -> tick == tick && e -> argc == argc ) {
+
+			size_t i = 0;
+
+			while ( i < argc && same(ctx, e -> args[i], argv[i]))
+				i++;
+
+			if ( i == argc ) {
+				this -> _hits++;
+				return &e -> result;
+			}
+		}
+	}
+
+	this -> _misses++;
+	return nullptr;
+}
+
+void expr::memo::store(const expr::context& ctx, const uint64_t site, const expr::FUNCTION *f, const uint64_t tick, const expr::value *argv, const size_t argc, const expr::value result) {
+
+	if ( argc > expr::memo::MAX_ARGS || this -> _capacity == 0 )
+		return;
+
+	if ( this -> _entries.empty())
+		this -> _entries.resize(this -> _capacity);
+
+	ENTRY *e = this -> entry(ctx, site, f, argv, argc);
+
+	if ( e -> site == 0 )
+		this -> _size++;
+	else this -> _evictions++;
+
+	e -> site = site;
+	e -> function = f -> generation();
+	e -> tick = tick;
+	e -> argc = argc;
+
+	for ( size_t i = 0; i < argc; i++ )
+		assign(ctx, e -> args[i], argv[i]);
+
+	assign(ctx, e -> result, result);
+}
+
+const expr::CACHE_STATS expr::memo::stats() const {
+
+	return {
+		.hits = this -> _hits,
+		.misses = this -> _misses,
+		.evictions = this -> _evictions,
+		.size = this -> _size,
+		.capacity = this -> _capacity
+	};
+}
+
+void expr::memo::resize(const size_t capacity) {
+
+	this -> _capacity = 0;
+
+	if ( capacity > 0 )
+		for ( this -> _capacity = 1; this -> _capacity < capacity; this -> _capacity <<= 1 );
+
+	this -> _entries.clear();
+	this -> _size = 0;
+}
+
+void expr::memo::clear() {
+
+	this -> _entries.clear();
+	this -> _size = 0;
+	this -> _hits = 0;
+	this -> _misses = 0;
+	this -> _evictions = 0;
+}
@@ -0,0 +1,217 @@
+#include <cmath>
+#include <algorithm>
+#include "common.hpp"
+#include "logger.hpp"
+#include "expr/program.hpp"
+#include "expr/expression.hpp"
+
+static bool is_literal(const expr::TOKEN& token) {
+
+	return token == expr::T_NUMBER || token == expr::T_STRING;
+}
+
+// sign of zero is compared too, -0 is not 0
+static bool is_number(const expr::TOKEN& token, const double n) {
+
+	return token == expr::T_NUMBER && token.raw_double() == n &&
+		std::signbit(token.raw_double()) == std::signbit(n);
+}
+
+static bool is_empty_string(const expr::TOKEN& token) {
+
+	return token == expr::T_STRING && token.raw_string().empty();
+}
+
+// true when token's value is a number, whatever its operands are
+static bool numeric_result(const expr::TOKEN& token) {
+
+	switch ( token.type()) {
+		case expr::T_NUMBER:
+			return true;
+		case expr::T_SUB:
+			return !token.child().empty() && numeric_result(token.child().front());
+		case expr::T_CONDITIONAL:
+			return !token.cond1().empty() && !token.cond2().empty() &&
+				numeric_result(token.cond1().front()) && numeric_result(token.cond2().front());
+		case expr::T_OPERATOR:
+			switch ( token.op()) {
+				case expr::OP_CAT:
+				case expr::OP_SET:
+				case expr::OP_COM:
+				case expr::OP_UNDEF:
+					return false;
+				case expr::OP_ADD:
+					return token.args().size() == 2 && numeric_result(token.args()[1]);
+				default:
+					return true;
+			}
+		default:
+			return false;
+	}
+}
+
+// true when token's value is a string, whatever its operands are
+static bool string_result(const expr::TOKEN& token) {
+
+	switch ( token.type()) {
+		case expr::T_STRING:
+			return true;
+		case expr::T_SUB:
+			return !token.child().empty() && string_result(token.child().front());
+		case expr::T_CONDITIONAL:
+			return !token.cond1().empty() && !token.cond2().empty() &&
+				string_result(token.cond1().front()) && string_result(token.cond2().front());
+		case expr::T_OPERATOR:
+			return token.op() == expr::OP_CAT;
+		default:
+			return false;
+	}
+}
+
+static void assume(std::vector<std::string>& names, const std::string& name) {
+
+	if ( std::find(names.begin(), names.end(), name) == names.end())
+		names.push_back(name);
+}
+
+// evaluates token that has only literal operands, result is undefined on failure
+static expr::TOKEN evaluate_constant(const expr::TOKEN& token) {
+
+	expr::program p(token);
+	return p.run(nullptr, nullptr);
+}
+
+// copy of operator or function call with folded operands. Operands are
+// folded one by one from token, so that subtrees are not copied
+expr::TOKEN expr::expression::operands_folded(const expr::TOKEN& token, std::vector<std::string>& variables, std::vector<std::string>& functions) {
+
+	expr::TOKEN result;
+
+	result._type = token._type;
+	result._op = token._op;
+	result._raw = token._raw;
+	result._value = token._value;
+	result._name = token._name;
+	result._args.reserve(token._args.size());
+
+	// target of SET is not a value
+	for ( size_t i = 0; i < token._args.size(); i++ ) {
+
+		if ( i == 0 && token == expr::OP_SET )
+			result._args.push_back(token._args[i]);
+		else result._args.push_back(fold(token._args[i], variables, functions));
+	}
+
+	return result;
+}
+
+expr::TOKEN expr::expression::fold(const expr::TOKEN& token, std::vector<std::string>& variables, std::vector<std::string>& functions) {
+
+	switch ( token._type ) {
+
+		case expr::T_VARIABLE:
+
+			if ( !expr::program::is_named_constant(token._name))
+				return token;
+
+			assume(variables, token._name);
+			return expr::TOKEN::NUMBER(expr::program::named_constant(token._name).to_double());
+
+		case expr::T_FUNCTION: {
+
+				expr::TOKEN result = operands_folded(token, variables, functions);
+				bool constant = std::all_of(result._args.begin(), result._args.end(), is_literal);
+
+				if ( !constant || !expr::functions::is_pure(token._name) ||
+					!expr::functions::builtin_functions.contains(token._name))
+					return result;
+
+				expr::TOKEN value = evaluate_constant(result);
+
+				if ( value == expr::T_UNDEF )
+					return result;
+
+				assume(functions, token._name);
+				return value;
+			}
+
+		case expr::T_OPERATOR: {
+
+				expr::TOKEN result = operands_folded(token, variables, functions);
+
+				if ( result._args.empty() || result._op == expr::OP_SET )
+					return result;
+
+				if ( std::all_of(result._args.begin(), result._args.end(), is_literal)) {
+
+					expr::TOKEN value = evaluate_constant(result);
+					return value == expr::T_UNDEF ? result : value;
+				}
+
+				if ( result._args.size() != 2 )
+					return result;
+
+				const expr::TOKEN& lhs = result._args[0];
+				const expr::TOKEN& rhs = result._args[1];
+
+				// identities that hold for every x, -0 included. x + 0 and x / 1
+				// do not: -0 + 0 is 0 and ops::DIV gives 0 for zero numerator
+				switch ( result._op ) {
+					case expr::OP_AND2:
+						if ( is_literal(lhs) && lhs.to_double() == 0 ) return expr::TOKEN::NUMBER(0);
+						break;
+					case expr::OP_OR2:
+						if ( is_literal(lhs) && lhs.to_double() != 0 ) return expr::TOKEN::NUMBER(1);
+						break;
+					case expr::OP_MUL:
+						if ( is_number(rhs, 1) && numeric_result(lhs)) return std::move(result._args[0]);
+						if ( is_number(lhs, 1) && numeric_result(rhs)) return std::move(result._args[1]);
+						break;
+					case expr::OP_SUB:
+						if ( is_number(rhs, 0) && numeric_result(lhs)) return std::move(result._args[0]);
+						break;
+					case expr::OP_POW:
+						if ( is_number(rhs, 1) && numeric_result(lhs)) return std::move(result._args[0]);
+						break;
+					case expr::OP_CAT:
+						if ( is_empty_string(rhs) && string_result(lhs)) return std::move(result._args[0]);
+						if ( is_empty_string(lhs) && string_result(rhs)) return std::move(result._args[1]);
+						break;
+					default:
+						break;
+				}
+
+				return result;
+			}
+
+		case expr::T_SUB:
+
+			if ( token._child.empty())
+				return token;
+
+			return fold(token._child.front(), variables, functions);
+
+		case expr::T_CONDITIONAL: {
+
+				if ( token._child.empty() || token._cond1.empty() || token._cond2.empty())
+					return token;
+
+				expr::TOKEN condition = fold(token._child.front(), variables, functions);
+
+				if ( is_literal(condition))
+					return condition.to_double() == 0 ?
+						fold(token._cond2.front(), variables, functions) :
+						fold(token._cond1.front(), variables, functions);
+
+				expr::TOKEN result;
+				result = expr::T_CONDITIONAL;
+				result._child.push_back(std::move(condition));
+				result._cond1.push_back(fold(token._cond1.front(), variables, functions));
+				result._cond2.push_back(fold(token._cond2.front(), variables, functions));
+				return result;
+			}
+
+		default:
+			return token;
+	}
+}
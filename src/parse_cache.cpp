@@ -0,0 +1,84 @@
+#include "expr/parse_cache.hpp"
+
+expr::parse_cache::parse_cache(const size_t capacity) : _capacity(capacity) {
+}
+
+std::shared_ptr<const expr::expression> expr::parse_cache::get(const std::string& source) {
+
+	{
+		std::lock_guard<std::mutex> lock(this -> _mutex);
+
+		if ( auto it = this -> _index.find(source); it != this -> _index.end()) {
+
+			this -> _entries.splice(this -> _entries.begin(), this -> _entries, it -> second);
+			this -> _hits++;
+			return it -> second -> second;
+		}
+
+		this -> _misses++;
+	}
+
+	// parsed without lock, other threads may parse same source meanwhile
+	std::shared_ptr<const expr::expression> e = std::make_shared<const expr::expression>(source);
+
+	std::lock_guard<std::mutex> lock(this -> _mutex);
+
+	if ( auto it = this -> _index.find(source); it != this -> _index.end())
+		return it -> second -> second;
+
+	if ( this -> _capacity == 0 )
+		return e;
+
+	this -> _entries.emplace_front(source, e);
+	this -> _index.emplace(std::string_view(this -> _entries.front().first), this -> _entries.begin());
+	this -> evict();
+	return e;
+}
+
+void expr::parse_cache::evict() {
+
+	while ( this -> _entries.size() > this -> _capacity ) {
+
+		this -> _index.erase(std::string_view(this -> _entries.back().first));
+		this -> _entries.pop_back();
+		this -> _evictions++;
+	}
+}
+
+const expr::CACHE_STATS expr::parse_cache::stats() const {
+
+	std::lock_guard<std::mutex> lock(this -> _mutex);
+
+	return {
+		.hits = this -> _hits,
+		.misses = this -> _misses,
+		.evictions = this -> _evictions,
+		.size = this -> _entries.size(),
+		.capacity = this -> _capacity
+	};
+}
+
+void expr::parse_cache::resize(const size_t capacity) {
+
+	std::lock_guard<std::mutex> lock(this -> _mutex);
+
+	this -> _capacity = capacity;
+	this -> evict();
+}
+
+void expr::parse_cache::clear() {
+
+	std::lock_guard<std::mutex> lock(this -> _mutex);
+
+	this -> _index.clear();
+	this -> _entries.clear();
+	this -> _hits = 0;
+	this -> _misses = 0;
+	this -> _evictions = 0;
+}
+
+expr::parse_cache& expr::parse_cache::global() {
+
+	static expr::parse_cache c;
+	return c;
+}
@@ -1,672 +1,340 @@
-#include <map>
-#include <tsl/ordered_map.h>
-#include "common.hpp"
 #include "logger.hpp"
+#include "expr/lexer.hpp"
 #include "expr/expression.hpp"
 
-// important note: longest operator patterns in the beginning, shortest in the end
-static tsl::ordered_map<std::string, expr::OP> Pattern1 = {
-	{ "==", expr::OP_NEQ },
-	{ "!=", expr::OP_NNE },
-	{ "<=", expr::OP_NLE },
-	{ "=<", expr::OP_NLE },
-	{ ">=", expr::OP_NGE },
-	{ "=>", expr::OP_NGE },
-	{ "&&", expr::OP_AND2 },
-	{ "||", expr::OP_OR2 },
-	{ "<", expr::OP_NLT },
-	{ ">", expr::OP_NGT },
-	{ "|", expr::OP_OR },
-	{ "&", expr::OP_AND },
-	{ "!", expr::OP_NOT },
-	{ "+", expr::OP_ADD },
-	{ "-", expr::OP_SUB },
-	{ ".", expr::OP_CAT },
-	{ "*", expr::OP_MUL },
-	{ "/", expr::OP_DIV },
-	{ ",", expr::OP_COM },
-	{ "%", expr::OP_MOD },
-	{ "^", expr::OP_POW },
-	{ "=", expr::OP_SET },
+// operator precedence, higher value binds tighter
+enum PRECEDENCE {
+	P_NONE = 0,
+	P_SET,
+	P_CONDITIONAL,
+	P_OR,
+	P_AND,
+	P_EQUALITY,
+	P_COMPARISON,
+	P_CAT,
+	P_TERM,
+	P_FACTOR,
+	P_POW,
+	P_UNARY
 };
 
-// important note: longest operator patterns in the beginning, shortest in the end
-static tsl::ordered_map<std::string, expr::OP> Pattern2 = {
-	{ "eq", expr::OP_SEQ },
-	{ "ne", expr::OP_SNE },
-	{ "lt", expr::OP_SLT },
-	{ "le", expr::OP_SLE },
-	{ "gt", expr::OP_SGT },
-	{ "ge", expr::OP_SGE }
-};
-
-static std::string unsupported_characters = "#$¢€:;@[]_\\";
+static int precedence(const expr::OP op) {
+
+	switch ( op ) {
+		case expr::OP_SET: return P_SET;
+		case expr::OP_OR:
+		case expr::OP_OR2: return P_OR;
+		case expr::OP_AND:
+		case expr::OP_AND2: return P_AND;
+		case expr::OP_NEQ:
+		case expr::OP_NNE:
+		case expr::OP_SEQ:
+		case expr::OP_SNE: return P_EQUALITY;
+		case expr::OP_NLT:
+		case expr::OP_NLE:
+		case expr::OP_NGT:
+		case expr::OP_NGE:
+		case expr::OP_SLT:
+		case expr::OP_SLE:
+		case expr::OP_SGT:
+		case expr::OP_SGE: return P_COMPARISON;
+		case expr::OP_CAT: return P_CAT;
+		case expr::OP_ADD:
+		case expr::OP_SUB: return P_TERM;
+		case expr::OP_MUL:
+		case expr::OP_DIV:
+		case expr::OP_MOD: return P_FACTOR;
+		case expr::OP_POW: return P_POW;
+		default: return P_NONE;
+	}
+}
 
-std::vector<expr::TOKEN> expr::expression::parse_expr(const std::string& expr, bool f_args) {
+static bool right_associative(const expr::OP op) {
 
-	std::string s(expr);
-	std::vector<TOKEN> tokens;
-	unsigned char quote = 0;
-	std::string word;
-	bool ignore;
+	return op == expr::OP_POW || op == expr::OP_SET;
+}
 
-	TOKEN token;
+static bool starts_operand(const expr::LEXEME& l) {
 
-	while ( !s.empty()) {
+	return l.type == expr::L_NAME || l.type == expr::L_NUMBER ||
+		l.type == expr::L_STRING || l.type == expr::L_LPAREN;
+}
 
-		token.reset();
-		ignore = false;
+static void close_parentheses(expr::lexer& lex) {
 
-		while ( common::starts_with_space(s)) // || unsupported_tokens.find_first_of(s.front()) != std::string::npos )
-			s.erase(0, 1);
+	if ( lex.peek().type == expr::L_RPAREN )
+		lex.next();
+	else logger::warning["parser"] << "uneven braces in <" << lex.source() << ">" << std::endl;
+}
 
-		if ( unsupported_characters.find_first_of(s.front()) != std::string::npos ) {
+expr::TOKEN expr::expression::parse_operand(expr::lexer& lex) {
 
-			std::string ignored_word;
+	TOKEN token;
 
-			while ( unsupported_characters.find_first_of(s.front()) != std::string::npos )
-				ignored_word += s.erase(0, 1);
+	while ( true ) {
 
-			logger::warning["parser"] << "ignoring unsupported characters '" << ignored_word <<
-				"' at <" << expr << ">" << std::endl;
+		const LEXEME& next = lex.peek();
 
-			if ( tokens.size() > 1 && tokens.back() == expr::T_OPERATOR )
-				tokens.pop_back();
+		if ( next.type == expr::L_END || next.type == expr::L_RPAREN ||
+			next.type == expr::L_COLON || ( next.type == expr::L_OPERATOR && next.op == expr::OP_COM )) {
 
-			continue;
+			logger::error["parser"] << "value missing from expression <" << lex.source() << ">" << std::endl;
+			return token; // T_UNDEF
 		}
 
-		if ( s.empty())
-			break;
-
-		if ( common::starts_with_alpha(s)) { /* names */
-
-			word += common::erase_front(s);
-
-			while ( common::starts_with_alnum(s) || unsupported_characters.find_first_of(s.front()) != std::string::npos )
-				word += common::erase_front(s);
+		LEXEME l = lex.next();
 
-			token = expr::T_VARIABLE;
+		switch ( l.type ) {
 
-			/* check for alphanumeric operators */
-			for ( const auto& [key, op] : Pattern2 ) {
-
-				if ( word == key ) {
-					token = op;
-					break;
-				}
-			}
-
-			if ( token == expr::T_VARIABLE )
-				token._name = word;
-
-		} else if ( common::starts_with_digit(s) || ( s.front() == '.' && common::is_digit(s.at(1)))) { /* numbers */
-
-			while ( common::starts_with_digit(s))
-				word += common::erase_front(s);
-
-			if ( s.front() == '.' ) {
-
-				word += common::erase_front(s);
-
-				while ( common::starts_with_digit(s))
-					word += common::erase_front(s);
-			}
-
-			if ( common::starts_with_alpha(s)) {
-
-				while ( common::starts_with_alnum(s))
-					word += common::erase_front(s);
+			case expr::L_NAME:
 
 				token = expr::T_VARIABLE;
-				token._name = word;
+				token._name = std::string(lex.text(l));
 
-			} else {
+				if ( lex.peek().type == expr::L_LPAREN && lex.peek().offset == l.offset + l.length ) {
 
-				token = expr::T_NUMBER;
-				try {
-					token = std::stod(word);
-				} catch ( std::invalid_argument& e ) {
-					logger::error["parser"] << "cannot convert '" << word << "' to number" << std::endl;
-					token = (double)0;
-				}
-			}
-
-		} else if ( s.front() == '\'' || s.front() == '"' ) { /* string */
-
-			quote = common::erase_front(s);
-
-			while ( !s.empty() && s.front() != quote ) {
-
-				if ( s.front() == '\\' ) {
-
-					switch ( s.size() > 1 ? s.at(1) : 0 ) {
-						case '\\':
-						case '\'':
-							word += '\'';
-							s.erase(0, 2);
-							break;
-						case 'a':
-							word += '\a';
-							s.erase(0, 2);
-							break;
-						case 'b':
-							word += '\b';
-							s.erase(0, 2);
-							break;
-						case 't':
-							word += '\t';
-							s.erase(0, 2);
-							break;
-						case 'n':
-							word += '\n';
-							s.erase(0, 2);
-							break;
-						case 'v':
-							word += '\v';
-							s.erase(0, 2);
-							break;
-						case 'f':
-							word += '\f';
-							s.erase(0, 2);
-							break;
-						case 'r':
-							word += '\r';
-							s.erase(0, 2);
-							break;
-						case 'x': {
-								int i;
-								unsigned char hexC;
-								int hex[2];
-
-								for ( i = 0; i < 2; i++ ) {
-
-									hexC = s.at(2 + i);
-
-									if ( hexC >= '0' && hexC <= '9' )
-										hex[i] = hexC - '0';
-									if ( hexC >= 'a' && hexC <= 'f' )
-										hex[i] = hexC - 'a' + 10;
-									if ( hexC >= 'A' && hexC <= 'F' )
-										hex[i] = hexC - 'A' + 10;
-									else break;
-								}
-
-								switch ( i ) {
-									case 1:
-										hexC = hex[0];
-										s.erase(0, 3);
-										break;
-									case 2:
-										hexC = hex[0] * 16 + hex[1];
-										s.erase(0, 4);
-										break;
-									default:
-										logger::warning["parser"] <<
-											"Illegal hex sequence '\\x" << s.at(2) << "' in <" <<
-											expr << "> keeps unchanged" << std::endl;
-										hexC = '\\';
-										s.erase(0, 1);
-								}
-
-								if ( hexC == 0 )
-									logger::warning["parser"] <<
-										"Null character(s) in <" << expr << "> will be ignored" << std::endl;
-								else word += hexC;
-							}
-							break;
-						case '0':
-						case '1':
-						case '2':
-						case '3':
-							if ( s.at(2) >= '0' && s.at(2) <= '7' &&
-								s.at(3) >= '0' && s.at(3) <= '7' ) {
-
-								word += (( s.at(1) - '0' ) * 64 + ( s.at(2) - '0' ) * 8 + ( s.at(3) - '0' ));
-								s.erase(0, 4);
-							} else {
-								logger::warning["parser"] <<
-									"illegal octal sequence '\\" <<
-									s.at(1) << s.at(2) << s.at(3) <<
-									"' in <" << expr << ">" << std::endl;
-								word += common::erase_front(s);
-							}
-							break;
-						default:
-							logger::warning["parser"] <<
-								"unknown escape sequence '\\" << s.at(1) <<
-								"' in <" << expr << ">" << std::endl;
-							word += common::erase_front(s);
-					}
-				} else word += common::erase_front(s);
-			}
-
-			token = expr::T_STRING;
-
-			if ( s.front() == quote )
-				s.erase(0, 1);
-			else
-				logger::warning["parser"] <<
-					"unterminated string in <" << expr << ">" << std::endl;
-
-			token._value = word;
+					lex.next();
+					token = expr::T_FUNCTION;
 
-		} else { /* non-alpha operators */
+					while ( lex.peek().type != expr::L_RPAREN && lex.peek().type != expr::L_END ) {
 
-			bool skip = false;
+						token._args.push_back(parse_expr(lex, P_NONE));
 
-			for ( const auto& [key, op] : Pattern1 ) {
-
-				if ( s.size() >= key.size() && s.starts_with(key)) {
-
-					if ( op == expr::OP_COM && !f_args ) {
-						logger::warning["parser"] <<
-							"comma operator is allowed only when defining function arguments <" << expr << ">" << std::endl;
-						continue;
-					}
-
-					token = op;
-					word = common::erase_prefix(s, key.size());
-
-					if ( tokens.size() > 1 && token == expr::OP_SUB &&
-						tokens[tokens.size() - 1] == expr::OP_SUB &&
-						tokens[tokens.size() - 2] == expr::OP_SUB ) {
-						tokens.pop_back(); // 2 negation signs in row negate their selves
-						skip = true;
-					} else if ( tokens.size() == 1 && token == expr::OP_SUB && tokens.back() == expr::OP_SUB ) {
-						tokens.pop_back(); // 2 negation signs in row negate their selves
-						skip = true;
-					} else if ( token == expr::OP_NOT && !tokens.empty() && tokens.back() == expr::OP_NOT ) {
-						tokens.back() = expr::OP_NNOT;
-						skip = true;
-					} else if ( token == expr::OP_NOT && !tokens.empty() && tokens.back() == expr::OP_NNOT ) {
-						tokens.back() = expr::OP_NOT;
-						skip = true;
-					} else if ( token == expr::OP_NOT && !tokens.empty() && tokens.back() == expr::OP_SUB ) {
-						logger::error["parser"] <<
-							"operator NOT(!) is not allowed to follow operator SGN or SUB (-), if you must " <<
-							"use it, place NOT expression inside parentheses, ignoring NOT(!) now" << std::endl;
-						skip = true;
+						if ( lex.peek().type == expr::L_OPERATOR && lex.peek().op == expr::OP_COM )
+							lex.next();
+						else break;
 					}
 
-					break;
+					close_parentheses(lex);
 				}
-			}
-
-			if ( skip ) {
-				token.reset();
-				word = "";
-				continue;
-			}
 
-		}
+				return token;
 
-		if ( !s.empty() && s.front() == '(' && token != expr::OP_SUB ) {
-
-			bool escaping = false;
-			char quote = 0;
-			int brace_level = 1;
-			std::string child_expr;
-
-			s.erase(0, 1);
-			while ( !s.empty() && brace_level > 0 ) {
-
-				if ( quote == 0 && ( s.front() == '\'' || s.front() == '"' )) quote = s.front();
-				else if ( quote != 0 && !escaping && s.front() == '\\' ) escaping = true;
-				else if ( quote != 0 && !escaping && s.front() == quote ) quote = 0;
-				else if ( quote == 0 && s.front() == '(' ) brace_level++;
-				else if ( quote == 0 && s.front() == ')' ) {
-					brace_level--;
-					if ( brace_level == 0 ) {
-						s.erase(0, 1);
-						break;
-					}
-				} else if ( escaping ) escaping = false;
+			case expr::L_NUMBER:
 
-				child_expr += common::erase_front(s);
-			}
+				token = lex.number(l);
+				return token;
 
-			if ( brace_level != 0 )
-				logger::warning["parser"] << "uneven braces in <" << expr << ">" << std::endl;
+			case expr::L_STRING:
 
-			if ( token == expr::T_VARIABLE ) {
-				token = expr::T_FUNCTION;
-				token._args = parse_expr(child_expr, true);
+				token = lex.string(l);
+				return token;
 
-			} else if ( token == expr::T_UNDEF ) {
+			case expr::L_LPAREN:
 
 				token = expr::T_SUB;
-				token._child = parse_expr(child_expr, false);
-			}
-		}
-
-		if ( !s.empty() && s.front() == '?' && token == expr::T_UNDEF ) {
-
-			bool escaping = false;
-			char quote = 0;
-			int brace_level = 0;
-			std::string expr1;
-			std::string expr2;
-			bool cnd_complete = false;
-			bool abort = false;
-
-			s.erase(0, 1);
-
-			while (common::starts_with_space(s))
-				s.erase(0, 1);
-
-			while ( !s.empty() && !cnd_complete ) {
-
-				if ( quote == 0 && ( s.front() == '\'' || s.front() == '"' )) quote = s.front();
-				else if ( quote != 0 && !escaping && s.front() == '\\' ) escaping = true;
-				else if ( quote != 0 && !escaping && s.front() == quote ) quote = 0;
-				else if ( quote == 0 && s.front() == '(' )
-					brace_level++;
-				else if ( quote == 0 && s.front() == ')' )
-					brace_level--;
-				else if ( quote == 0 && brace_level == 0 && s.front() == ':' ) {
-					cnd_complete = true;
-					s.erase(0, 1);
-					break;
-				} else if ( escaping ) escaping = false;
-
-				expr1 += common::erase_front(s);
-			}
+				token._child.push_back(parse_expr(lex, P_NONE));
+				close_parentheses(lex);
+				return token;
+
+			case expr::L_OPERATOR:
+
+				if ( l.op == expr::OP_SUB || l.op == expr::OP_NOT ) {
+
+					TOKEN operand = parse_expr(lex, P_UNARY);
+
+					if ( l.op == expr::OP_SUB && operand == expr::OP_SUB && operand._args.size() == 1 )
+						return operand._args.front(); // 2 negation signs in row negate their selves
+					else if ( l.op == expr::OP_NOT && operand == expr::OP_NOT && operand._args.size() == 1 )
+						operand._op = expr::OP_NNOT;
+					else if ( l.op == expr::OP_NOT && operand == expr::OP_NNOT )
+						operand._op = expr::OP_NOT;
+					else {
+						token = l.op;
+						token._args.push_back(std::move(operand));
+						return token;
+					}
 
-			if ( !cnd_complete ) {
-				if ( quote != 0 )
-					logger::error["parser"] << "uneven quotes inside condition <" << expr << ">" << std::endl;
-				else if ( brace_level != 0 )
-					logger::error["parser"] << "uneven braces inside condition <" << expr << ">" << std::endl;
-				else {
-					logger::error["parser"] << "invalid condition, operator COL(:) and false result missing, " <<
-						"syntax is x( != 0 ) ? true : false" << std::endl;
-					logger::verbose["parser"] << "invalid condition found from <" << expr << ">" << std::endl;
+					return operand;
 				}
 
-				abort = true;
-			}
+				logger::error["parser"] << "left side value missing from expression, ignoring operator " <<
+					describe(l.op) << " <" << lex.source() << ">" << std::endl;
+				continue;
 
-			if ( !abort && expr1.empty()) {
-				logger::error["parser"] << "error, conditionals true result is null <" << expr << " >" << std::endl;
-				expr1 = "0";
-			}
+			case expr::L_QUESTION:
 
-			while (common::starts_with_space(s))
-                                s.erase(0, 1);
-
-			escaping = false;
-			quote = 0;
-			brace_level = 0;
-			cnd_complete = false;
-
-			while ( !abort && !s.empty() && !cnd_complete ) {
-
-				if ( quote == 0 && ( s.front() == '\'' || s.front() == '"' )) quote = s.front();
-				else if ( quote != 0 && !escaping && s.front() == '\\' ) escaping = true;
-				else if ( quote != 0 && !escaping && s.front() == quote ) quote = 0;
-				else if ( quote == 0 && s.front() == '(' )
-					brace_level++;
-				else if ( quote == 0 && s.front() == ')' )
-					brace_level--;
-				else if ( quote == 0 && brace_level == 0 && s.front() == ' ' ) {
-					cnd_complete = true;
-					s.erase(0, 1);
-					break;
-				} else if ( escaping ) escaping = false;
-
-                                expr2 += common::erase_front(s);
-                        }
-
-			if ( !abort && s.empty() && quote == 0 && brace_level == 0 )
-				cnd_complete = true;
-
-			if ( !abort && !cnd_complete ) {
-				if ( quote != 0 )
-					logger::error["parser"] << "uneven quotes inside condition <" << expr << ">" << std::endl;
-				else if ( brace_level != 0 )
-					logger::error["parser"] << "uneven braces inside condition <" << expr << ">" << std::endl;
-				else
-					logger::error["parser"] << "unknown condition parsing error with < " << expr << ">" << std::endl;
-
-				abort = true;
-			}
+				logger::error["parser"] << "conditional expression without condition, ignoring <" << lex.source() << ">" << std::endl;
+				parse_expr(lex, P_NONE);
 
-			if ( !abort && expr2.empty()) {
-				logger::error["parser"] << "error, conditionals false result is null <" << expr << " >" << std::endl;
-				expr2 = "0";
-			}
+				if ( lex.peek().type == expr::L_COLON ) {
+					lex.next();
+					parse_expr(lex, P_CONDITIONAL);
+				}
 
-			if ( !abort ) {
-				token = expr::T_CONDITIONAL;
-				token._cond1 = parse_expr(expr1, false);
-				token._cond2 = parse_expr(expr2, false);
-			}
+				return token; // T_UNDEF
 
-			s += "   "; // Add some white-space, next part may remove it..
+			default:
+				continue;
 		}
+	}
+}
 
-		if ( !f_args && token == expr::T_UNDEF && !s.empty())
-			s.erase(0, 1);
-
-		while ( common::starts_with_space(s))
-			s.erase(0, 1);
-
-		// last checks..
-
-		if ( !ignore && !tokens.empty() && token == expr::T_OPERATOR && tokens.back() == expr::T_OPERATOR ) {
-
-			if ( !(( token == expr::OP_SUB && tokens.back() == expr::OP_SUB ) ||
-				( token == expr::OP_SUB && tokens.back() == expr::OP_NOT ) ||
-				( token == expr::OP_SUB && tokens.back() == expr::OP_NNOT ) ||
-				( token == expr::OP_NOT && tokens.back() == expr::OP_SUB ) ||
-				( token == expr::OP_NNOT && tokens.back() == expr::OP_SUB ))) {
+expr::TOKEN expr::expression::parse_expr(expr::lexer& lex, int level) {
 
-				logger::warning["parser"] << "2 mathematical modifier operators ( " << describe(token._op) <<
-					" and " << describe(tokens.back()._op) << " cannot be in row, ignoring operator " <<
-					describe(token._op) << std::endl;
+	TOKEN lhs = parse_operand(lex);
 
-				ignore = true;
-			}
-		}
+	while ( true ) {
 
-		if ( !tokens.empty() && tokens.back() == expr::T_UNDEF && token == expr::T_UNDEF ) { // failsafe, but is it good..???
-			s.erase(0, 1);
-			ignore = true;
-		}
+		const LEXEME& next = lex.peek();
 
-		if ( !ignore )
-			tokens.push_back(token);
+		if ( next.type == expr::L_QUESTION ) {
 
-		token.reset();
-		word = "";
+			if ( level > P_CONDITIONAL )
+				break;
 
-	}
+			lex.next();
 
-	return tokens;
-}
+			TOKEN cond1 = parse_expr(lex, P_NONE);
 
-bool expr::expression::validate_set_op(std::vector<expr::TOKEN>& tokens, const std::string& expr, bool is_root) {
+			if ( lex.peek().type != expr::L_COLON ) {
+				logger::error["parser"] << "invalid condition, operator COL(:) and false result missing, " <<
+					"syntax is x( != 0 ) ? true : false" << std::endl;
+				logger::verbose["parser"] << "invalid condition found from <" << lex.source() << ">" << std::endl;
+				break;
+			}
 
-	bool result = true;
-	bool restart;
+			lex.next();
 
-	begin_validate:
+			TOKEN token;
+			token = expr::T_CONDITIONAL;
+			token._child.push_back(std::move(lhs));
+			token._cond1.push_back(std::move(cond1));
+			token._cond2.push_back(parse_expr(lex, P_CONDITIONAL));
+			lhs = std::move(token);
+			continue;
+		}
 
-	restart = false;
+		OP op;
 
-	for ( size_t i = 0; i < tokens.size(); i++ ) {
+		if ( next.type == expr::L_OPERATOR && next.op != expr::OP_COM )
+			op = next.op;
+		else if ( starts_operand(next)) {
 
-		if ( is_root && i == 1 && tokens[i] == T_OPERATOR && tokens[i] == OP_SET ) {
+			logger::verbose["parser"] << "operator missing between values, using ADD(+) <" << lex.source() << ">" << std::endl;
+			op = expr::OP_ADD;
 
-			if ( tokens[0] == T_VARIABLE && tokens.size() > 2 &&
-				tokens[2] != OP_COM ) continue;
-			else if ( tokens[0] == T_VARIABLE && tokens.size() > 2 &&
-				tokens[2] == OP_SET ) {
+		} else if ( next.type == expr::L_UNKNOWN ) {
 
-				logger::warning["validator"] << "multiple SET operators in sequence, removing " <<
-					"extra operators <" << expr << ">" << std::endl;
+			lex.next();
+			continue;
 
-					while ( tokens.size() > 2 && tokens[2] == OP_SET )
-						tokens.erase(tokens.begin() + 2);
+		} else break;
 
-					result = false;
-					restart = true;
-					break;
+		int p = precedence(op);
 
-			} else if ( tokens[0] != expr::T_VARIABLE || tokens[0]._name.empty()) {
+		if ( p == P_NONE ) {
 
-				logger::error["validator"] << "SET operator used, but left side " <<
-					"argument's type is not a variable, ignoring SET <" << expr << ">" << std::endl;
+			logger::error["parser"] << "operator " << describe(op) << " cannot be used between values, ignoring it <" <<
+				lex.source() << ">" << std::endl;
+			lex.next();
+			continue;
+		}
 
-				tokens.erase(tokens.begin(), tokens.begin() + 2);
-				result = false;
-				restart = true;
-				break;
+		if ( p < level )
+			break;
 
-			} else if ( tokens.size() == 2 ) {
+		if ( next.type == expr::L_OPERATOR )
+			lex.next();
 
-				logger::error["validator"] << "SET operator used, but right side " <<
-					"argument is missing, ignoring SET <" << expr << ">" << std::endl;
+		TOKEN rhs = parse_expr(lex, right_associative(op) ? p : p + 1);
 
-				tokens.erase(tokens.begin() + 1);
-				result = false;
-				restart = true;
-				break;
-			}
+		if ( rhs == expr::T_UNDEF ) {
 
-			logger::error["validator"] << "SET operator used and unexpected unknown " <<
-				"error occurred, ignoring SET <" << expr << ">" << std::endl;
-			tokens.erase(tokens.begin() + 1);
-			result = false;
-			restart = true;
-			break;
+			logger::error["parser"] << "operator " << describe(op) << " with missing right side value, ignoring it <" <<
+				lex.source() << ">" << std::endl;
+			continue;
 		}
 
-		if ( is_root && i == 0 && tokens[i] == T_OPERATOR && tokens[i] == OP_SET ) {
+		if ( op == expr::OP_SET ) {
 
-			logger::error["validator"] << "SET operator used, but left side " <<
-				"argument's type is not a variable, ignoring SET <" << expr << ">" << std::endl;
-
-			tokens.erase(tokens.begin());
-			result = false;
-			restart = true;
-			break;
+			logger::error["parser"] << "SET operator in wrong place, SET can only be used in beginning of " <<
+				"expression as second argument after variable argument, ignoring SET <" << lex.source() << ">" << std::endl;
+			lhs = std::move(rhs);
+			continue;
 		}
 
-		if ( tokens[i] == T_OPERATOR && tokens[i] == OP_SET ) {
-
-			logger::error["validator"] << "SET operator in wrong place, SET can " <<
-				"only be used in beginning of expression as second argument after variable argument" << std::endl;
-			logger::error["validator"] << "ignoring SET <" << expr << ">" << std::endl;
-
-			tokens.erase(i == 0 ? tokens.begin() : ( tokens.begin() + ( i + 1 )));
-			result = false;
-			restart = true;
-			break;
-		}
+		TOKEN token;
+		token = op;
+		token._args.push_back(std::move(lhs));
+		token._args.push_back(std::move(rhs));
+		lhs = std::move(token);
+	}
 
-		if ( tokens[i] == T_CONDITIONAL ) {
+	return lhs;
+}
 
-			if ( !tokens[i]._cond1.empty() && !validate_set_op(tokens[i]._cond1, expr, false)) {
+expr::TOKEN expr::expression::parse_expr(const std::string& s) {
 
-				result = false;
-				logger::vverbose["validator"] << "SET expression failure in conditionals true result" << std::endl;
-				break;
+	expr::lexer lex(s);
+	TOKEN root;
 
-			} else if ( !validate_set_op(tokens[i]._cond2, expr, false)) {
+	if ( lex.peek().type == expr::L_END )
+		return root;
 
-				result = false;
-				logger::vverbose["validator"] << "SET expression failure in conditionals false result" << std::endl;
-				break;
-			}
+	LEXEME first = lex.peek();
+	std::string set_variable;
 
-		} else if ( tokens[i] == expr::T_SUB && !tokens[i]._child.empty() &&
-			!validate_set_op(tokens[i]._child, expr, false)) {
+	if ( first.type == expr::L_NAME ) {
 
-				result = false;
-				logger::vverbose["validator"] << "SET expression failure in expression inside parentheses" << std::endl;
-				break;
+		lex.next();
 
-		} else if ( tokens[i] == expr::T_FUNCTION ) {
+		if ( lex.peek().type == expr::L_OPERATOR && lex.peek().op == expr::OP_SET ) {
 
-			bool func_reset;
+			lex.next();
+			set_variable = std::string(lex.text(first));
+		} else lex = expr::lexer(s);
+	}
 
-			begin_func_validation:
+	root = parse_expr(lex, P_NONE);
 
-			func_reset = false;
+	while ( lex.peek().type != expr::L_END ) {
 
-			for ( size_t arg_i = 0; arg_i < tokens[i]._args.size(); arg_i++ ) {
+		LEXEME l = lex.next();
 
-				if ( tokens[i]._args[arg_i] == expr::OP_SET ) {
+		if ( l.type == expr::L_RPAREN )
+			logger::warning["parser"] << "uneven braces in <" << s << ">" << std::endl;
+		else if ( l.type == expr::L_OPERATOR && l.op == expr::OP_COM )
+			logger::warning["parser"] << "comma operator is allowed only when defining function arguments <" << s << ">" << std::endl;
+		else logger::warning["parser"] << "ignoring unexpected '" << lex.text(l) << "' in <" << s << ">" << std::endl;
 
-					logger::error["validator"] << "SET operator in wrong place, SET is not allowed " <<
-						"in functions arguments, ignoring SET <" << expr << ">" << std::endl;
+		if ( lex.peek().type == expr::L_END )
+			break;
 
-					result = false;
-					tokens[i]._args.erase(arg_i == 0 ? tokens[i]._args.begin() : ( tokens[i]._args.begin() + arg_i ));
-					func_reset = true;
-					break;
-				}
-			}
+		TOKEN rest = parse_expr(lex, P_NONE);
 
-			if ( func_reset )
-				goto begin_func_validation;
-
-			begin_comma_validation:
-
-			func_reset = false;
-
-			for ( size_t arg_i = 0; arg_i < tokens[i]._args.size(); arg_i++ ) {
-
-				if ( arg_i == 0 && tokens[i]._args[arg_i] == expr::OP_COM ) {
-
-					logger::verbose["sanitizer"] << "Double COM(,) operator after validating SET " <<
-						"operators from function args, ignoring COM operator <" << expr << ">" << std::endl;
-					tokens[i]._args.erase(arg_i == 0 ? tokens[i]._args.begin() : ( tokens[i]._args.begin() + arg_i ));
-					result = false;
-					func_reset = true;
-					break;
-
-				} else if ( arg_i < ( tokens[i]._args.size() - 1 ) &&
-					tokens[i]._args[arg_i] == expr::OP_COM && tokens[i]._args[arg_i + 1] == expr::OP_COM ) {
-
-					logger::verbose["sanitizer"] << "Double COM(,) operator after validating SET " <<
-						"operators from function args, ignoring COM operator <" << expr << ">" << std::endl;
-					tokens[i]._args.erase(arg_i == 0 ? tokens[i]._args.begin() : ( tokens[i]._args.begin() + arg_i ));
-					result = false;
-					func_reset = true;
-					break;
-				} else if ( arg_i < (tokens[i]._args.size() - 1 ) &&
-					tokens[i]._args[arg_i] == expr::T_OPERATOR && tokens[i]._args[arg_i + 1] == expr::OP_COM ) {
-					logger::verbose["sanitizer"] << "function argument's last argument is operator " <<
-						describe(tokens[i]._args[arg_i]._op) << " which cannot work, ignoring it <" << expr << ">" << std::endl;
-					tokens[i]._args.erase(arg_i == 0 ? tokens[i]._args.begin() : ( tokens[i]._args.begin() + arg_i ));
-					result = false;
-					func_reset = true;
-					break;
-				}
-			}
+		if ( rest != expr::T_UNDEF ) {
 
-			if ( func_reset )
-				goto begin_comma_validation;
+			TOKEN token;
+			token = expr::OP_ADD;
+			token._args.push_back(std::move(root));
+			token._args.push_back(std::move(rest));
+			root = std::move(token);
 		}
 	}
 
-	if ( restart )
-		goto begin_validate;
+	if ( !set_variable.empty()) {
 
-	return result;
-}
+		if ( root == expr::T_UNDEF ) {
+
+			logger::error["validator"] << "SET operator used, but right side " <<
+				"argument is missing, ignoring SET <" << s << ">" << std::endl;
 
-std::vector<expr::TOKEN> expr::expression::parse_expr(const std::string& s) {
+			root = expr::T_VARIABLE;
+			root._name = set_variable;
+			return root;
+		}
 
-	std::vector<expr::TOKEN> tokens = parse_expr(s, false);
+		TOKEN variable;
+		variable = expr::T_VARIABLE;
+		variable._name = set_variable;
 
-	if ( !tokens.empty() && !validate_set_op(tokens, describe(tokens), true)) {
-		logger::warning["sanitizer"] << "failures in expression with SET argument <" << s << ">" << std::endl;
-		logger::vverbose["sanitizer"] << "expression might be broken, expression after sanitizing: <" << describe(tokens) << ">" << std::endl;
+		TOKEN token;
+		token = expr::OP_SET;
+		token._args.push_back(std::move(variable));
+		token._args.push_back(std::move(root));
+		root = std::move(token);
 	}
 
-	return tokens;
+	return root;
 }
@@ -0,0 +1,349 @@
+#include <cmath>
+#include <sstream>
+#include <atomic>
+#include <algorithm>
+#include <utility>
+#include "common.hpp"
+#include "logger.hpp"
+#include "expr/program.hpp"
+
+const bool expr::program::is_named_constant(const std::string& name) {
+
+	std::string s = common::to_lower(std::as_const(name));
+	return s == "true" || s == "false" || s == "pi" || s == "pi_2" || s == "pi_4" || s == "e";
+}
+
+const expr::VARIABLE expr::program::named_constant(const std::string& name) {
+
+	std::string s = common::to_lower(std::as_const(name));
+
+	if ( s == "true" ) return expr::VARIABLE((double)1);
+	else if ( s == "false" ) return expr::VARIABLE((double)0);
+	else if ( s == "pi" ) return expr::VARIABLE((double)M_PI);
+	else if ( s == "pi_2" ) return expr::VARIABLE((double)M_PI_2);
+	else if ( s == "pi_4" ) return expr::VARIABLE((double)M_PI_4);
+	else if ( s == "e" ) return expr::VARIABLE((double)M_E);
+
+	return expr::VARIABLE(std::string(""));
+}
+
+expr::program::program() {
+}
+
+expr::program::program(const expr::TOKEN& root) {
+
+	static std::atomic<uint64_t> ids = 0;
+
+	if ( root == expr::T_UNDEF )
+		return;
+
+	this -> _id = ++ids;
+
+	if ( root == expr::OP_SET && root.args().size() == 2 ) {
+		this -> _set_variable = root.args()[0].name();
+		this -> _set_symbol = expr::symbols::global().identifier(this -> _set_variable);
+		this -> compile(root.args()[1]);
+	} else this -> compile(root);
+}
+
+const uint32_t expr::program::add_constant(const expr::VARIABLE& v) {
+
+	if ( const double *d = std::get_if<double>(&v))
+		this -> _constants.push_back(expr::value::NUMBER(*d));
+	else if ( const std::string *s = std::get_if<std::string>(&v)) {
+		this -> _constants.push_back(expr::value::STRING((uint32_t)this -> _strings.size()));
+		this -> _strings.push_back(*s);
+	}
+	else this -> _constants.push_back(expr::value::NULLPTR());
+
+	return (uint32_t)(this -> _constants.size() - 1);
+}
+
+const uint32_t expr::program::name(const std::string& s) {
+
+	expr::SYMBOL id = expr::symbols::global().identifier(s);
+
+	for ( size_t i = 0; i < this -> _names.size(); i++ )
+		if ( this -> _names[i] == id )
+			return (uint32_t)i;
+
+	this -> _names.push_back(id);
+	return (uint32_t)(this -> _names.size() - 1);
+}
+
+void expr::program::emit(const expr::INSTRUCTION& i, const int stack_change) {
+
+	this -> _code.push_back(i);
+	this -> _depth += stack_change;
+
+	if ( this -> _depth > this -> _max_depth )
+		this -> _max_depth = this -> _depth;
+}
+
+void expr::program::compile(const expr::TOKEN& token) {
+
+	switch ( token.type()) {
+
+		case expr::T_NUMBER:
+		case expr::T_STRING:
+			this -> emit({ .code = expr::I_CONST, .a = this -> add_constant(expr::VARIABLE(token.value())) }, 1);
+			return;
+
+		case expr::T_VARIABLE:
+			this -> emit({ .code = expr::I_LOAD, .a = this -> name(token.name()),
+				.b = this -> add_constant(named_constant(token.name())) }, 1);
+			return;
+
+		case expr::T_FUNCTION:
+
+			for ( const expr::TOKEN& arg : token.args())
+				this -> compile(arg);
+
+			this -> emit({ .code = expr::I_CALL, .a = this -> name(token.name()),
+				.b = (uint32_t)token.args().size() }, 1 - (int)token.args().size());
+			return;
+
+		case expr::T_OPERATOR:
+
+			if ( token.args().size() == 1 ) {
+
+				this -> compile(token.args()[0]);
+
+				if ( token.op() != expr::OP_SUB && token.op() != expr::OP_NOT && token.op() != expr::OP_NNOT )
+					logger::error["evaluate"] << "operator " << describe(token.op()) << " cannot be used without left side value" << std::endl;
+				else this -> emit({ .code = expr::I_UNARY, .op = token.op() }, 0);
+				return;
+			}
+
+			if ( token.args().size() != 2 ) {
+				logger::error["evaluate"] << "operator " << describe(token.op()) << " with missing values" << std::endl;
+				break;
+			}
+
+			this -> compile(token.args()[0]);
+
+			if ( token.op() == expr::OP_AND2 || token.op() == expr::OP_OR2 ) {
+
+				// right side is evaluated only when left side does not decide result
+				size_t jump = this -> _code.size();
+				this -> emit({ .code = token.op() == expr::OP_AND2 ? expr::I_AND : expr::I_OR }, -1);
+				this -> compile(token.args()[1]);
+				this -> emit({ .code = expr::I_UNARY, .op = expr::OP_NNOT }, 0);
+				this -> _code[jump].a = (uint32_t)this -> _code.size();
+				return;
+			}
+
+			this -> compile(token.args()[1]);
+			this -> emit({ .code = expr::I_BINARY, .op = token.op() }, -1);
+			return;
+
+		case expr::T_SUB:
+
+			if ( token.child().empty()) {
+				logger::error["evaluate"] << "cannot evaluate value inside parentheses, it is considered as null" << std::endl;
+				break;
+			}
+
+			this -> compile(token.child().front());
+			return;
+
+		case expr::T_CONDITIONAL: {
+
+				if ( token.child().empty() || token.cond1().empty() || token.cond2().empty()) {
+					logger::error["evaluate"] << "conditional expression without condition, ignoring" << std::endl;
+					break;
+				}
+
+				this -> compile(token.child().front());
+
+				size_t jump_false = this -> _code.size();
+				this -> emit({ .code = expr::I_JUMP_FALSE }, -1);
+				this -> compile(token.cond1().front());
+
+				size_t jump = this -> _code.size();
+				this -> emit({ .code = expr::I_JUMP }, -1); // only one of branches is left on stack
+				this -> _code[jump_false].a = (uint32_t)this -> _code.size();
+				this -> compile(token.cond2().front());
+				this -> _code[jump].a = (uint32_t)this -> _code.size();
+			}
+			return;
+
+		default:
+			break;
+	}
+
+	this -> emit({ .code = expr::I_CONST, .a = this -> add_constant(expr::VARIABLE()) }, 1);
+}
+
+const expr::program expr::program::bind(const expr::SCHEMA& schema, std::vector<std::string>& unbound) const {
+
+	expr::program p(*this);
+	expr::symbols& symbols = expr::symbols::global();
+	std::vector<expr::SYMBOL> names;
+
+	names.reserve(schema.size());
+
+	for ( const std::string& name : schema )
+		names.push_back(symbols.identifier(name));
+
+	auto slot = [&names](const expr::SYMBOL id) {
+
+		for ( size_t i = 0; i < names.size(); i++ )
+			if ( names[i] == id )
+				return (int)i;
+
+		return -1;
+	};
+
+	for ( expr::INSTRUCTION& in : p._code ) {
+
+		if ( in.code != expr::I_LOAD )
+			continue;
+
+		if ( int i = slot(p._names[in.a]); i != -1 ) {
+			in.code = expr::I_SLOT;
+			in.a = (uint32_t)i;
+		} else {
+
+			const std::string& name = symbols.string(p._names[in.a]);
+
+			if ( std::find(unbound.begin(), unbound.end(), name) == unbound.end())
+				unbound.push_back(name);
+
+			in.code = expr::I_CONST;
+			in.a = in.b;
+		}
+	}
+
+	if ( !p._set_variable.empty()) {
+
+		p._set_slot = slot(p._set_symbol);
+
+		if ( p._set_slot == -1 && std::find(unbound.begin(), unbound.end(), p._set_variable) == unbound.end())
+			unbound.push_back(p._set_variable);
+	}
+
+	return p;
+}
+
+void expr::program::link(expr::FUNCTIONMAP *functions, std::vector<std::string>& unknown) {
+
+	this -> _handles.assign(this -> _names.size(), nullptr);
+
+	for ( expr::INSTRUCTION& in : this -> _code ) {
+
+		if ( in.code != expr::I_CALL && in.code != expr::I_LINKED )
+			continue;
+
+		const std::string& name = expr::symbols::global().string(this -> _names[in.a]);
+		in.code = expr::I_LINKED;
+
+		if ( this -> _handles[in.a] != nullptr )
+			continue;
+		else if ( functions != nullptr && functions -> contains(name))
+			this -> _handles[in.a] = &(*functions)[name];
+		else if ( expr::functions::builtin_functions.contains(name))
+			this -> _handles[in.a] = &expr::functions::builtin_functions[name];
+		else if ( std::find(unknown.begin(), unknown.end(), name) == unknown.end()) {
+
+			logger::warning["link"] << "unknown function " << name << ", calls to it result null" << std::endl;
+			unknown.push_back(name);
+		}
+	}
+}
+
+const std::vector<expr::INSTRUCTION>& expr::program::code() const {
+	return this -> _code;
+}
+
+const std::vector<expr::value>& expr::program::constants() const {
+	return this -> _constants;
+}
+
+const expr::VARIABLE expr::program::constant(const uint32_t index) const {
+
+	const expr::value c = this -> _constants[index];
+
+	if ( c.is_number())
+		return expr::VARIABLE(c.number());
+	else if ( c.is_string())
+		return expr::VARIABLE(this -> _strings[c.string()]);
+
+	return expr::VARIABLE();
+}
+
+const std::vector<expr::SYMBOL>& expr::program::names() const {
+	return this -> _names;
+}
+
+const std::string expr::program::set_variable() const {
+	return this -> _set_variable;
+}
+
+const bool expr::program::empty() const {
+	return this -> _code.empty();
+}
+
+const std::string describe(const expr::OPCODE& code) {
+
+	switch ( code ) {
+		case expr::I_CONST: return "CONST";
+		case expr::I_LOAD: return "LOAD";
+		case expr::I_SLOT: return "SLOT";
+		case expr::I_CALL: return "CALL";
+		case expr::I_LINKED: return "LINKED";
+		case expr::I_UNARY: return "UNARY";
+		case expr::I_BINARY: return "BINARY";
+		case expr::I_JUMP: return "JUMP";
+		case expr::I_JUMP_FALSE: return "JUMP_FALSE";
+		case expr::I_AND: return "AND";
+		case expr::I_OR: return "OR";
+	}
+
+	return "UNKNOWN";
+}
+
+const std::string describe(const expr::program& p) {
+
+	std::stringstream ss;
+
+	for ( size_t i = 0; i < p.code().size(); i++ ) {
+
+		const expr::INSTRUCTION& in = p.code()[i];
+
+		ss << i << ": " << describe(in.code);
+
+		switch ( in.code ) {
+			case expr::I_CONST:
+				ss << " " << p.constant(in.a).describe();
+				break;
+			case expr::I_LOAD:
+				ss << " " << expr::symbols::global().string(p.names()[in.a]);
+				break;
+			case expr::I_SLOT:
+				ss << " " << in.a;
+				break;
+			case expr::I_CALL:
+			case expr::I_LINKED:
+				ss << " " << expr::symbols::global().string(p.names()[in.a]) << "/" << in.b;
+				break;
+			case expr::I_UNARY:
+			case expr::I_BINARY:
+				ss << " " << describe(in.op);
+				break;
+			case expr::I_JUMP:
+			case expr::I_JUMP_FALSE:
+			case expr::I_AND:
+			case expr::I_OR:
+				ss << " " << in.a;
+				break;
+		}
+
+		ss << "\n";
+	}
+
+	if ( !p.set_variable().empty())
+		ss << "SET " << p.set_variable() << "\n";
+
+	return ss.str();
+}
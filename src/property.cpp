@@ -2,6 +2,7 @@
 #include "logger.hpp"
 #include "expr/property.hpp"
 #include "expr/expression.hpp"
+#include "expr/parse_cache.hpp"
 
 expr::PROPERTY::PROPERTY() {
 
@@ -44,11 +45,15 @@ expr::RESULT expr::PROPERTY::get(const std::string& key, const std::variant<doub
 		!this -> _map -> contains(key) || (*this -> _map)[key].empty())
 		return expr::RESULT(def);
 
-	expr::expression e((*this -> _map)[key]);
-	std::string pretty = e.operator std::string();
+	return expr::PROPERTY::value(*expr::parse_cache::global().get((*this -> _map)[key]), this -> _funcs, this -> _vars, def);
+}
+
+expr::RESULT expr::PROPERTY::value(const expr::expression& e, expr::FUNCTIONMAP *f, expr::VARIABLEMAP *v,
+	const std::variant<double, std::string, std::nullptr_t>& def) {
 
 	try {
-		expr::RESULT result = e.evaluate(this -> _funcs, this -> _vars);
+		expr::RESULT result = e.is_constant(f, v) ?
+			expr::RESULT(e.constant_value()) : expr::RESULT(e.evaluate(f, v));
 
 		if (( result.is_string() && !(result.operator std::string()).empty()) || result.is_number()) {
 
@@ -60,6 +65,8 @@ expr::RESULT expr::PROPERTY::get(const std::string& key, const std::variant<doub
 
 		} else if ( result.is_string() && result.operator std::string().empty()) {
 
+			std::string pretty = e.operator std::string();
+
 			if ( !std::holds_alternative<std::nullptr_t>(def))
 				return expr::RESULT(def);
 			else if ( !pretty.empty())
@@ -134,8 +141,7 @@ const std::string expr::PROPERTY::pretty(const std::string& key) {
 		!this -> _map -> contains(key) || (*this -> _map)[key].empty())
 		return "nullptr";
 
-	expr::expression e((*this -> _map)[key]);
-	return e.operator std::string();
+	return expr::parse_cache::global().get((*this -> _map)[key]) -> operator std::string();
 }
 
 const expr::expression expr::PROPERTY::expression(const std::string& key) {
@@ -144,5 +150,5 @@ const expr::expression expr::PROPERTY::expression(const std::string& key) {
 		!this -> _map -> contains(key) || (*this -> _map)[key].empty())
 		return expr::expression();
 
-	return expr::expression((*this -> _map)[key]);
+	return *expr::parse_cache::global().get((*this -> _map)[key]);
 }
@@ -0,0 +1,341 @@
+#include <sstream>
+#include <atomic>
+#include "logger.hpp"
+#include "expr/program.hpp"
+#include "expr/register_program.hpp"
+
+// temporaries are numbered after constants, but count of constants is
+// known only after lowering, so they are flagged and relocated at end
+static const uint32_t TEMPORARY = 0x80000000;
+
+#ifndef EXPR_NO_SUPERINSTRUCTIONS
+static bool is_comparator(const expr::OP op) {
+
+	return op == expr::OP_NEQ || op == expr::OP_NNE ||
+		op == expr::OP_NLT || op == expr::OP_NLE ||
+		op == expr::OP_NGT || op == expr::OP_NGE;
+}
+#endif
+
+expr::register_program::register_program() {
+}
+
+expr::register_program::register_program(const expr::expression& e) : expr::register_program(e.root()) {
+}
+
+expr::register_program::register_program(const expr::TOKEN& root) {
+
+	static std::atomic<uint64_t> ids = 0;
+
+	if ( root == expr::T_UNDEF )
+		return;
+
+	this -> _id = ++ids;
+
+	uint32_t result;
+
+	if ( root == expr::OP_SET && root.args().size() == 2 ) {
+		this -> _set_variable = root.args()[0].name();
+		result = this -> lower(root.args()[1], 0);
+	} else result = this -> lower(root, 0);
+
+	this -> emit({ .code = expr::R_HALT, .a = result });
+
+	this -> _constants = this -> _registers.size();
+	this -> _registers.resize(this -> _constants + this -> _temporaries);
+
+	auto relocate = [this](uint32_t& r) {
+		if ( r & TEMPORARY ) r = (uint32_t)this -> _constants + ( r & ~TEMPORARY );
+	};
+
+	for ( expr::RINSTRUCTION& in : this -> _code ) {
+
+		relocate(in.dst);
+
+		switch ( in.code ) {
+			case expr::R_HALT:
+			case expr::R_MOVE:
+			case expr::R_UNARY:
+			case expr::R_JUMP_FALSE:
+			case expr::R_AND:
+			case expr::R_OR:
+				relocate(in.a);
+				break;
+			case expr::R_BINARY:
+				relocate(in.a);
+				relocate(in.b);
+				break;
+			default:
+				break;
+		}
+	}
+
+	// handlers are resolved once, so that running does not modify program
+	this -> execute(nullptr, nullptr, &this -> _handlers);
+}
+
+const uint32_t expr::register_program::constant(const expr::VARIABLE& v) {
+
+	this -> _registers.push_back(v);
+	return (uint32_t)(this -> _registers.size() - 1);
+}
+
+const uint32_t expr::register_program::temporary(const uint32_t index) {
+
+	if ( index + 1 > this -> _temporaries )
+		this -> _temporaries = index + 1;
+
+	return index | TEMPORARY;
+}
+
+const uint32_t expr::register_program::name(const std::string& s) {
+
+	expr::SYMBOL id = expr::symbols::global().identifier(s);
+
+	for ( size_t i = 0; i < this -> _names.size(); i++ )
+		if ( this -> _names[i] == id )
+			return (uint32_t)i;
+
+	this -> _names.push_back(id);
+	return (uint32_t)(this -> _names.size() - 1);
+}
+
+void expr::register_program::emit(const expr::RINSTRUCTION& i) {
+
+	this -> _code.push_back(i);
+}
+
+void expr::register_program::lower_into(const expr::TOKEN& token, const uint32_t target) {
+
+	uint32_t r = this -> lower(token, target);
+
+	if ( r != this -> temporary(target))
+		this -> emit({ .code = expr::R_MOVE, .dst = this -> temporary(target), .a = r });
+}
+
+// lowers token, returns register holding its value. Temporary
+// registers from target and above are free for use
+const uint32_t expr::register_program::lower(const expr::TOKEN& token, const uint32_t target) {
+
+	switch ( token.type()) {
+
+		case expr::T_NUMBER:
+		case expr::T_STRING:
+			return this -> constant(expr::VARIABLE(token.value()));
+
+		case expr::T_VARIABLE:
+			this -> emit({ .code = expr::R_LOAD, .dst = this -> temporary(target), .a = this -> name(token.name()),
+				.b = this -> constant(expr::program::named_constant(token.name())) });
+			return this -> temporary(target);
+
+		case expr::T_FUNCTION:
+
+#ifndef EXPR_NO_SUPERINSTRUCTIONS
+			if ( token.args().empty() && expr::functions::builtin_functions.contains(token.name())) {
+
+				this -> _builtins.push_back(&expr::functions::builtin_functions[token.name()]);
+				this -> emit({ .code = expr::R_CALL0, .dst = this -> temporary(target), .a = this -> name(token.name()),
+					.b = (uint32_t)(this -> _builtins.size() - 1) });
+				return this -> temporary(target);
+			}
+#endif
+
+			for ( size_t i = 0; i < token.args().size(); i++ )
+				this -> lower_into(token.args()[i], target + i);
+
+			this -> emit({ .code = expr::R_CALL, .dst = this -> temporary(target), .a = this -> name(token.name()),
+				.b = (uint32_t)token.args().size() });
+			return this -> temporary(target);
+
+		case expr::T_OPERATOR:
+
+			if ( token.args().size() == 1 ) {
+
+				uint32_t r = this -> lower(token.args()[0], target);
+
+				if ( token.op() != expr::OP_SUB && token.op() != expr::OP_NOT && token.op() != expr::OP_NNOT ) {
+					logger::error["evaluate"] << "operator " << describe(token.op()) << " cannot be used without left side value" << std::endl;
+					return r;
+				}
+
+				this -> emit({ .code = expr::R_UNARY, .op = token.op(), .dst = this -> temporary(target), .a = r });
+				return this -> temporary(target);
+			}
+
+			if ( token.args().size() != 2 ) {
+				logger::error["evaluate"] << "operator " << describe(token.op()) << " with missing values" << std::endl;
+				break;
+			}
+
+#ifndef EXPR_NO_SUPERINSTRUCTIONS
+			if ( token.args()[0] == expr::T_VARIABLE && token.args()[1] == expr::T_NUMBER &&
+				( is_comparator(token.op()) || token.op() == expr::OP_MUL )) {
+
+				const expr::TOKEN& variable = token.args()[0];
+
+				this -> emit({ .code = token.op() == expr::OP_MUL ? expr::R_LOAD_MUL_CONST : expr::R_LOAD_CMP_CONST,
+					.op = token.op(), .dst = this -> temporary(target), .a = this -> name(variable.name()),
+					.b = this -> constant(expr::program::named_constant(variable.name())),
+					.c = this -> constant(expr::VARIABLE(token.args()[1].value())) });
+				return this -> temporary(target);
+			}
+#endif
+
+			if ( token.op() == expr::OP_AND2 || token.op() == expr::OP_OR2 ) {
+
+				// right side is evaluated only when left side does not decide result
+				this -> lower_into(token.args()[0], target);
+
+				size_t jump = this -> _code.size();
+				this -> emit({ .code = token.op() == expr::OP_AND2 ? expr::R_AND : expr::R_OR, .a = this -> temporary(target) });
+				this -> lower_into(token.args()[1], target);
+				this -> emit({ .code = expr::R_UNARY, .op = expr::OP_NNOT, .dst = this -> temporary(target), .a = this -> temporary(target) });
+				this -> _code[jump].b = (uint32_t)this -> _code.size();
+				return this -> temporary(target);
+			}
+
+			{
+				uint32_t lhs = this -> lower(token.args()[0], target);
+				uint32_t rhs = this -> lower(token.args()[1], target + 1);
+
+				this -> emit({ .code = expr::R_BINARY, .op = token.op(), .dst = this -> temporary(target), .a = lhs, .b = rhs });
+			}
+			return this -> temporary(target);
+
+		case expr::T_SUB:
+
+			if ( token.child().empty()) {
+				logger::error["evaluate"] << "cannot evaluate value inside parentheses, it is considered as null" << std::endl;
+				break;
+			}
+
+			return this -> lower(token.child().front(), target);
+
+		case expr::T_CONDITIONAL: {
+
+				if ( token.child().empty() || token.cond1().empty() || token.cond2().empty()) {
+					logger::error["evaluate"] << "conditional expression without condition, ignoring" << std::endl;
+					break;
+				}
+
+				uint32_t cond = this -> lower(token.child().front(), target);
+
+				size_t jump_false = this -> _code.size();
+				this -> emit({ .code = expr::R_JUMP_FALSE, .a = cond });
+				this -> lower_into(token.cond1().front(), target);
+
+				size_t jump = this -> _code.size();
+				this -> emit({ .code = expr::R_JUMP });
+				this -> _code[jump_false].b = (uint32_t)this -> _code.size();
+				this -> lower_into(token.cond2().front(), target);
+				this -> _code[jump].a = (uint32_t)this -> _code.size();
+			}
+			return this -> temporary(target);
+
+		default:
+			break;
+	}
+
+	return this -> constant(expr::VARIABLE());
+}
+
+const std::vector<expr::RINSTRUCTION>& expr::register_program::code() const {
+	return this -> _code;
+}
+
+const std::vector<expr::SYMBOL>& expr::register_program::names() const {
+	return this -> _names;
+}
+
+const size_t expr::register_program::constants() const {
+	return this -> _constants;
+}
+
+const size_t expr::register_program::registers() const {
+	return this -> _registers.size();
+}
+
+const std::string expr::register_program::set_variable() const {
+	return this -> _set_variable;
+}
+
+const bool expr::register_program::empty() const {
+	return this -> _code.empty();
+}
+
+const std::string describe(const expr::ROPCODE& code) {
+
+	switch ( code ) {
+		case expr::R_HALT: return "HALT";
+		case expr::R_MOVE: return "MOVE";
+		case expr::R_LOAD: return "LOAD";
+		case expr::R_CALL: return "CALL";
+		case expr::R_CALL0: return "CALL0";
+		case expr::R_UNARY: return "UNARY";
+		case expr::R_BINARY: return "BINARY";
+		case expr::R_LOAD_CMP_CONST: return "LOAD_CMP_CONST";
+		case expr::R_LOAD_MUL_CONST: return "LOAD_MUL_CONST";
+		case expr::R_JUMP: return "JUMP";
+		case expr::R_JUMP_FALSE: return "JUMP_FALSE";
+		case expr::R_AND: return "AND";
+		case expr::R_OR: return "OR";
+	}
+
+	return "UNKNOWN";
+}
+
+const std::string describe(const expr::register_program& p) {
+
+	const expr::symbols& symbols = expr::symbols::global();
+	std::stringstream ss;
+
+	for ( size_t i = 0; i < p.code().size(); i++ ) {
+
+		const expr::RINSTRUCTION& in = p.code()[i];
+
+		ss << i << ": " << describe(in.code);
+
+		switch ( in.code ) {
+			case expr::R_HALT:
+				ss << " r" << in.a;
+				break;
+			case expr::R_MOVE:
+				ss << " r" << in.dst << " = r" << in.a;
+				break;
+			case expr::R_LOAD:
+				ss << " r" << in.dst << " = " << symbols.string(p.names()[in.a]);
+				break;
+			case expr::R_CALL:
+				ss << " r" << in.dst << " = " << symbols.string(p.names()[in.a]) << "/" << in.b;
+				break;
+			case expr::R_CALL0:
+				ss << " r" << in.dst << " = " << symbols.string(p.names()[in.a]) << "()";
+				break;
+			case expr::R_UNARY:
+				ss << " r" << in.dst << " = " << describe(in.op) << " r" << in.a;
+				break;
+			case expr::R_BINARY:
+				ss << " r" << in.dst << " = r" << in.a << " " << describe(in.op) << " r" << in.b;
+				break;
+			case expr::R_LOAD_CMP_CONST:
+			case expr::R_LOAD_MUL_CONST:
+				ss << " r" << in.dst << " = " << symbols.string(p.names()[in.a]) << " " << describe(in.op) << " r" << in.c;
+				break;
+			case expr::R_JUMP:
+				ss << " " << in.a;
+				break;
+			case expr::R_JUMP_FALSE:
+			case expr::R_AND:
+			case expr::R_OR:
+				ss << " r" << in.a << " " << in.b;
+				break;
+		}
+
+		ss << "\n";
+	}
+
+	if ( !p.set_variable().empty())
+		ss << "SET " << p.set_variable() << "\n";
+
+	return ss.str();
+}
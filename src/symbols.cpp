@@ -0,0 +1,63 @@
+#include <mutex>
+#include <utility>
+#include "common.hpp"
+#include "expr/symbols.hpp"
+
+expr::symbols::symbols() {
+}
+
+const expr::SYMBOL expr::symbols::intern(std::string_view s) {
+
+	if ( expr::SYMBOL id = this -> find(s); id != expr::symbols::NONE )
+		return id;
+
+	std::unique_lock lock(this -> _mutex);
+
+	if ( auto it = this -> _ids.find(s); it != this -> _ids.end())
+		return it -> second;
+
+	size_t n = this -> _ids.size() + CHUNK_SIZE;
+	size_t index = std::bit_width(n) - CHUNK_BITS - 1;
+	std::unique_ptr<std::string[]>& chunk = this -> _chunks[index];
+
+	if ( chunk == nullptr )
+		chunk = std::make_unique<std::string[]>(CHUNK_SIZE << index);
+
+	std::string& stored = chunk[n - ( CHUNK_SIZE << index )];
+	stored = s;
+
+	this -> _ids.emplace(std::string_view(stored), (expr::SYMBOL)this -> _ids.size());
+	this -> _bytes += stored.size();
+	return (expr::SYMBOL)( this -> _ids.size() - 1 );
+}
+
+const expr::SYMBOL expr::symbols::identifier(std::string_view name) {
+
+	std::string s(name);
+	return this -> intern(common::to_lower(std::as_const(s)));
+}
+
+const expr::SYMBOL expr::symbols::find(std::string_view s) const {
+
+	std::shared_lock lock(this -> _mutex);
+	auto it = this -> _ids.find(s);
+	return it == this -> _ids.end() ? expr::symbols::NONE : it -> second;
+}
+
+const size_t expr::symbols::size() const {
+
+	std::shared_lock lock(this -> _mutex);
+	return this -> _ids.size();
+}
+
+const size_t expr::symbols::bytes() const {
+
+	std::shared_lock lock(this -> _mutex);
+	return this -> _bytes;
+}
+
+expr::symbols& expr::symbols::global() {
+
+	static expr::symbols s;
+	return s;
+}
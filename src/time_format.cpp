@@ -0,0 +1,174 @@
+#include <array>
+#include <clocale>
+#include <cstring>
+#include <charconv>
+#include <functional>
+#include <string_view>
+#include "expr/time_format.hpp"
+
+static const char *weekday_names[] = { "Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat" };
+static const char *month_names[] = { "Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec" };
+
+// number padded with zeros to width
+static void digits(std::string& out, const int value, const int width) {
+
+	char buf[16];
+	std::to_chars_result r = std::to_chars(buf, buf + sizeof(buf), value);
+
+	for ( int n = (int)( r.ptr - buf ); n < width; n++ )
+		out.push_back('0');
+
+	out.append(buf, r.ptr);
+}
+
+static void name(std::string& out, const char *names[], const int index, const int count) {
+
+	if ( index >= 0 && index < count )
+		out.append(names[index]);
+	else out.push_back('?');
+}
+
+static void libc(std::string& out, const std::string& format, const std::tm& tm) {
+
+	char buf[256];
+	size_t n = std::strftime(buf, sizeof(buf), format.c_str(), &tm);
+	out.append(buf, n);
+}
+
+// names of C locale are only right when LC_TIME is C
+static const bool c_names() {
+
+	const char *locale = std::setlocale(LC_TIME, nullptr);
+	return locale != nullptr && ( std::strcmp(locale, "C") == 0 || std::strcmp(locale, "POSIX") == 0 );
+}
+
+expr::time_format::time_format() {
+}
+
+expr::time_format::time_format(const std::string& format) : _format(format) {
+
+	size_t pos = 0;
+
+	while ( pos < format.size()) {
+
+		size_t next = format.find('%', pos);
+
+		if ( next == std::string::npos ) {
+			this -> text(format.substr(pos));
+			break;
+		}
+
+		this -> text(format.substr(pos, next - pos));
+		pos = next + 1;
+
+		// flags, width and E and O modifiers are glibc's
+		size_t end = pos;
+
+		while ( end < format.size() && std::string_view("_-0^#").find(format[end]) != std::string_view::npos )
+			end++;
+
+		while ( end < format.size() && format[end] >= '0' && format[end] <= '9' )
+			end++;
+
+		if ( end < format.size() && ( format[end] == 'E' || format[end] == 'O' ))
+			end++;
+
+		if ( end >= format.size()) {
+			this -> _fields.push_back({ .type = LIBC, .text = format.substr(next) });
+			break;
+		}
+
+		FIELD_TYPE type = LIBC;
+
+		if ( end == pos ) {
+
+			switch ( format[pos] ) {
+				case 'Y': type = YEAR; break;
+				case 'm': type = MONTH; break;
+				case 'd': type = DAY; break;
+				case 'H': type = HOUR; break;
+				case 'M': type = MINUTE; break;
+				case 'S': type = SECOND; break;
+				case 'j': type = YEAR_DAY; break;
+				case 'a': type = WEEKDAY_NAME; break;
+				case 'b': type = MONTH_NAME; break;
+				case 'h': type = MONTH_NAME; break;
+				case '%': type = TEXT; break;
+				default: break;
+			}
+		}
+
+		if ( type == TEXT )
+			this -> text("%");
+		else this -> _fields.push_back({ .type = type, .text = type == LIBC || type == WEEKDAY_NAME || type == MONTH_NAME ? format.substr(next, end + 1 - next) : "" });
+
+		pos = end + 1;
+	}
+}
+
+// text is joined to previous text field
+void expr::time_format::text(const std::string& s) {
+
+	if ( s.empty())
+		return;
+	else if ( !this -> _fields.empty() && this -> _fields.back().type == TEXT )
+		this -> _fields.back().text += s;
+	else this -> _fields.push_back({ .type = TEXT, .text = s });
+}
+
+const std::string& expr::time_format::source() const {
+
+	return this -> _format;
+}
+
+void expr::time_format::format(const std::tm& tm, std::string& out) const {
+
+	int c = -1; // locale is checked on first name
+
+	out.clear();
+
+	for ( const FIELD& field : this -> _fields ) {
+
+		if (( field.type == WEEKDAY_NAME || field.type == MONTH_NAME ) && c < 0 )
+			c = c_names() ? 1 : 0;
+
+		switch ( field.type ) {
+			case TEXT: out.append(field.text); break;
+			case YEAR: digits(out, tm.tm_year + 1900, 1); break;
+			case MONTH: digits(out, tm.tm_mon + 1, 2); break;
+			case DAY: digits(out, tm.tm_mday, 2); break;
+			case HOUR: digits(out, tm.tm_hour, 2); break;
+			case MINUTE: digits(out, tm.tm_min, 2); break;
+			case SECOND: digits(out, tm.tm_sec, 2); break;
+			case YEAR_DAY: digits(out, tm.tm_yday + 1, 3); break;
+			case WEEKDAY_NAME:
+				if ( c == 1 ) name(out, weekday_names, tm.tm_wday, 7);
+				else libc(out, field.text, tm);
+				break;
+			case MONTH_NAME:
+				if ( c == 1 ) name(out, month_names, tm.tm_mon, 12);
+				else libc(out, field.text, tm);
+				break;
+			case LIBC: libc(out, field.text, tm); break;
+		}
+	}
+}
+
+const std::string expr::time_format::format(const std::tm& tm) const {
+
+	std::string out;
+
+	this -> format(tm, out);
+	return out;
+}
+
+const expr::time_format& expr::time_format::cached(const std::string& format) {
+
+	static thread_local std::array<expr::time_format, 16> formats;
+	expr::time_format& f = formats[std::hash<std::string>{}(format) % formats.size()];
+
+	if ( f._fields.empty() || f._format != format )
+		f = expr::time_format(format);
+
+	return f;
+}
@@ -30,19 +30,19 @@ const std::string expr::TOKEN::name() const {
 	return this -> _name;
 }
 
-const std::vector<expr::TOKEN> expr::TOKEN::args() const {
+const std::vector<expr::TOKEN>& expr::TOKEN::args() const {
 	return this -> _args;
 }
 
-const std::vector<expr::TOKEN> expr::TOKEN::child() const {
+const std::vector<expr::TOKEN>& expr::TOKEN::child() const {
 	return this -> _child;
 }
 
-const std::vector<expr::TOKEN> expr::TOKEN::cond1() const {
+const std::vector<expr::TOKEN>& expr::TOKEN::cond1() const {
 	return this -> _cond1;
 }
 
-const std::vector<expr::TOKEN> expr::TOKEN::cond2() const {
+const std::vector<expr::TOKEN>& expr::TOKEN::cond2() const {
 	return this -> _cond2;
 }
 
@@ -266,51 +266,53 @@ const std::string describe(const expr::TOKEN& token) {
 	return "unknown type";
 }
 
-static const std::string describe(const std::vector<expr::TOKEN>& tokens, bool f_args) {
+static const std::string describe_branch(const expr::TOKEN& token) {
 
-	if ( tokens.empty())
-		return "";
+	if ( token.type() == expr::T_OPERATOR || token.type() == expr::T_CONDITIONAL )
+		return "( " + describe_expr(token) + " )";
 
-	std::string s;
+	return describe_expr(token);
+}
 
-	for ( auto const &token : tokens ) {
+const std::string describe_expr(const expr::TOKEN& token) {
 
-		if ( !s.empty())
-			s += ' ';
-
-		switch ( token.type()) {
-			case expr::T_OPERATOR:
-				if ( token.op() == expr::OP_COM && !s.empty())
-					s.pop_back();
-				s += describe(token.op());
-				break;
-			case expr::T_VARIABLE:
-				s += common::to_lower(token.name());
-				break;
-			case expr::T_FUNCTION:
-				s += common::to_lower(token.name()) + "(" + describe(token.args(), true) + ")";
-				break;
-			case expr::T_SUB:
-				s += "( " + describe(token.child(), false) + " )";
-				break;
-			case expr::T_CONDITIONAL:
-				s += "?";
-				if ( token.cond1().size() == 1 )
-					s += " " + describe(token.cond1(), false) + " :";
-				else s += " ( " + describe(token.cond1(), false) + " ) :";
-				if ( token.cond2().size() == 1 )
-					s += " " + describe(token.cond2(), false);
-				else s += " ( " + describe(token.cond2(), false) + " )";
-				break;
-			case expr::T_UNDEF:
-				s += "T_UNDEF";
-				break;
-			default:
-				if ( token.is_null()) s += "NULL";
-				else if ( token.is_string()) s += "'" + token.to_string() + "'";
-				else if ( token.is_number()) s += common::to_string(token.to_double());
-				else s += "UNK";
-		}
+	std::string s;
+
+	switch ( token.type()) {
+		case expr::T_OPERATOR:
+			if ( token.op() == expr::OP_SET && token.args().size() == 2 )
+				s = common::to_lower(token.args()[0].name()) + " = " + describe_expr(token.args()[1]);
+			else if ( token.args().size() == 1 )
+				s = describe(token.op()) + " " + describe_expr(token.args()[0]);
+			else if ( token.args().size() == 2 )
+				s = describe_expr(token.args()[0]) + " " + describe(token.op()) + " " + describe_expr(token.args()[1]);
+			else s = describe(token.op());
+			break;
+		case expr::T_VARIABLE:
+			s = common::to_lower(token.name());
+			break;
+		case expr::T_FUNCTION:
+			s = common::to_lower(token.name()) + "(" + describe(token.args()) + ")";
+			break;
+		case expr::T_SUB:
+			s = "( " + describe(token.child()) + " )";
+			break;
+		case expr::T_CONDITIONAL:
+			s = describe(token.child()) + " ?";
+			if ( !token.cond1().empty())
+				s += " " + describe_branch(token.cond1().front());
+			s += " :";
+			if ( !token.cond2().empty())
+				s += " " + describe_branch(token.cond2().front());
+			break;
+		case expr::T_UNDEF:
+			s = "T_UNDEF";
+			break;
+		default:
+			if ( token.is_null()) s = "NULL";
+			else if ( token.is_string()) s = "'" + token.to_string() + "'";
+			else if ( token.is_number()) s = common::to_string(token.to_double());
+			else s = "UNK";
 	}
 
 	return s;
@@ -343,10 +345,21 @@ std::ostream& operator <<(std::ostream& os, expr::OP const& o) {
 }
 
 std::ostream& operator <<(std::ostream& os, std::vector<expr::TOKEN> const& t) {
-	os << describe(t, false);
+	os << describe(t);
 	return os;
 }
 
 const std::string describe(const std::vector<expr::TOKEN>& tokens) {
-	return describe(tokens, false);
+
+	std::string s;
+
+	for ( auto const &token : tokens ) {
+
+		if ( !s.empty())
+			s += ", ";
+
+		s += describe_expr(token);
+	}
+
+	return s;
 }
@@ -7,6 +7,7 @@
 #include "common.hpp"
 #include "logger.hpp"
 #include "expr/token.hpp"
+#include "expr/ops.hpp"
 
 static void reset_math_errors() {
 
@@ -61,6 +62,124 @@ static bool math_error_handler(const std::string& name, const double n1, const d
 	return ret;
 }
 
+double expr::ops::SGN(const double n) {
+	return -n;
+}
+
+double expr::ops::OR(const double n1, const double n2) {
+	return n1 == 0 ? (double)( n2 != 0 ) : (double)1;
+}
+
+double expr::ops::AND(const double n1, const double n2) {
+	return n1 != 0 ? (double)( n2 != 0 ) : (double)0;
+}
+
+double expr::ops::NOT(const double n) {
+	return (double)( n == 0 );
+}
+
+double expr::ops::NNOT(const double n) {
+	return (double)!( n == 0 );
+}
+
+double expr::ops::ADD(const double n1, const double n2) {
+	return n1 + n2;
+}
+
+double expr::ops::SUB(const double n1, const double n2) {
+	return n1 - n2;
+}
+
+double expr::ops::MUL(const double n1, const double n2) {
+	return n1 * n2;
+}
+
+double expr::ops::DIV(const double n1, const double n2) {
+
+	if ( n2 == 0 ) {
+		logger::warning["evaluate"] << "division by zero (" << n1 << " / 0 )" << std::endl;
+		return (double)0;
+	} else if ( n1 == 0 )
+		return (double)0;
+
+	reset_math_errors();
+	double d = n1 / n2;
+	return math_error_handler("divide", n1, n2, "/") ? (double)0 : d;
+}
+
+double expr::ops::MOD(const double n1, const double n2) {
+
+	if ( n2 == 0 ) {
+		logger::warning["evaluate"] << "modulo by zero (" << n1 << " % 0 )" << std::endl;
+		return (double)0;
+	}
+
+	reset_math_errors();
+	double d = std::fmod(n1, n2);
+	return math_error_handler("modulo", n1, n2, "%") ? (double)0 : d;
+}
+
+double expr::ops::POW(const double n1, const double n2) {
+	return std::pow(n1, n2);
+}
+
+double expr::ops::NEQ(const double n1, const double n2) {
+	return n1 == n2 ? (double)1 : (double)0;
+}
+
+double expr::ops::NNE(const double n1, const double n2) {
+	return n1 != n2 ? (double)1 : (double)0;
+}
+
+double expr::ops::NLT(const double n1, const double n2) {
+	return n1 < n2 ? (double)1 : (double)0;
+}
+
+double expr::ops::NLE(const double n1, const double n2) {
+	return n1 <= n2 ? (double)1 : (double)0;
+}
+
+double expr::ops::NGT(const double n1, const double n2) {
+	return n1 > n2 ? (double)1 : (double)0;
+}
+
+double expr::ops::NGE(const double n1, const double n2) {
+	return n1 >= n2 ? (double)1 : (double)0;
+}
+
+std::string expr::ops::CAT(std::string_view s1, std::string_view s2) {
+
+	std::string s;
+	s.reserve(s1.size() + s2.size());
+	s.append(s1);
+	s.append(s2);
+	return s;
+}
+
+double expr::ops::SEQ(std::string_view s1, std::string_view s2) {
+	return s1.compare(s2) == 0 ? (double)1 : (double)0;
+}
+
+double expr::ops::SNE(std::string_view s1, std::string_view s2) {
+	return s1.compare(s2) != 0 ? (double)1 : (double)0;
+}
+
+double expr::ops::SLT(std::string_view s1, std::string_view s2) {
+	return s1.compare(s2) < 0 ? (double)1 : (double)0;
+}
+
+double expr::ops::SLE(std::string_view s1, std::string_view s2) {
+	return s1.compare(s2) <= 0 ? (double)1 : (double)0;
+}
+
+double expr::ops::SGT(std::string_view s1, std::string_view s2) {
+	return s1.compare(s2) > 0 ? (double)1 : (double)0;
+}
+
+double expr::ops::SGE(std::string_view s1, std::string_view s2) {
+	return s1.compare(s2) >= 0 ? (double)1 : (double)0;
+}
+
 expr::TOKEN expr::TOKEN::UNDEF() {
 
 	expr::TOKEN token;
@@ -71,7 +190,7 @@ expr::TOKEN expr::TOKEN::SGN(const double n) {
 
 	expr::TOKEN token;
 	token._type = expr::T_NUMBER;
-	token._value = -n;
+	token._value = expr::ops::SGN(n);
 	return token;
 }
 
@@ -79,7 +198,7 @@ expr::TOKEN expr::TOKEN::OR(const double n1, const double n2) {
 
 	expr::TOKEN token;
 	token._type = expr::T_NUMBER;
-	token._value = n1 == 0 ? (double)( n2 != 0 ) : (double)1;
+	token._value = expr::ops::OR(n1, n2);
 	return token;
 }
 
@@ -92,7 +211,7 @@ expr::TOKEN expr::TOKEN::AND(const double n1, const double n2) {
 
 	expr::TOKEN token;
 	token._type = expr::T_NUMBER;
-	token._value = n1 != 0 ? (double)( n2 != 0 ) : (double)0;
+	token._value = expr::ops::AND(n1, n2);
 	return token;
 }
 
@@ -105,7 +224,7 @@ expr::TOKEN expr::TOKEN::NOT(const double n) {
 
 	expr::TOKEN token;
 	token._type = expr::T_NUMBER;
-	token._value = (double)( n == 0 );
+	token._value = expr::ops::NOT(n);
 	return token;
 }
 
@@ -113,7 +232,7 @@ expr::TOKEN expr::TOKEN::NNOT(const double n) {
 
 	expr::TOKEN token;
 	token._type = expr::T_NUMBER;
-	token._value = (double)!( n == 0 );
+	token._value = expr::ops::NNOT(n);
 	return token;
 }
 
@@ -121,7 +240,7 @@ expr::TOKEN expr::TOKEN::ADD(const double n1, const double n2) {
 
 	expr::TOKEN token;
 	token._type = expr::T_NUMBER;
-	token._value = n1 + n2;
+	token._value = expr::ops::ADD(n1, n2);
 	return token;
 }
 
@@ -129,7 +248,7 @@ expr::TOKEN expr::TOKEN::SUB(const double n1, const double n2) {
 
 	expr::TOKEN token;
 	token._type = expr::T_NUMBER;
-	token._value = n1 - n2;
+	token._value = expr::ops::SUB(n1, n2);
 	return token;
 }
 
@@ -137,7 +256,7 @@ expr::TOKEN expr::TOKEN::CAT(const std::string& s1, const std::string& s2) {
 
 	expr::TOKEN token;
 	token._type = expr::T_STRING;
-	token._value = std::string(s1 + s2);
+	token._value = expr::ops::CAT(s1, s2);
 	return token;
 }
 
@@ -145,7 +264,7 @@ expr::TOKEN expr::TOKEN::MUL(const double n1, const double n2) {
 
 	expr::TOKEN token;
 	token._type = expr::T_NUMBER;
-	token._value = n1 * n2;
+	token._value = expr::ops::MUL(n1, n2);
 	return token;
 }
 
@@ -153,16 +272,7 @@ expr::TOKEN expr::TOKEN::DIV(const double n1, const double n2) {
 
 	expr::TOKEN token;
 	token._type = expr::T_NUMBER;
-	if ( n2 == 0 ) {
-		logger::warning["evaluate"] << "division by zero (" << n1 << " / 0 )" << std::endl;
-		token._value = (double)0;
-	} else if ( n1 == 0 ) {
-		token._value = (double)0;
-	} else {
-		reset_math_errors();
-		token._value = n1 / n2;
-		if ( math_error_handler("divide", n1, n2, "/")) token._value = (double)0;
-	}
+	token._value = expr::ops::DIV(n1, n2);
 	return token;
 }
 
@@ -170,14 +280,7 @@ expr::TOKEN expr::TOKEN::MOD(const double n1, const double n2) {
 
 	expr::TOKEN token;
 	token._type = expr::T_NUMBER;
-	if ( n2 == 0 ) {
-		logger::warning["evaluate"] << "modulo by zero (" << n1 << " % 0 )" << std::endl;
-		token._value = (double)0;
-	} else {
-		reset_math_errors();
-		token._value = std::fmod(n1, n2);
-		if ( math_error_handler("modulo", n1, n2, "%")) token._value = (double)0;
-	}
+	token._value = expr::ops::MOD(n1, n2);
 	return token;
 }
 
@@ -185,15 +288,15 @@ expr::TOKEN expr::TOKEN::POW(const double n1, const double n2) {
 
 	expr::TOKEN token;
 	token._type = expr::T_NUMBER;
-	token._value = std::pow(n1, n2);
+	token._value = expr::ops::POW(n1, n2);
 	return token;
 }
 
 expr::TOKEN expr::TOKEN::NEQ(const double n1, const double n2) {
 
 	expr::TOKEN token;
-	token._type = T_NUMBER;
-	token._value = n1 == n2 ? (double)1 : (double)0;
+	token._type = expr::T_NUMBER;
+	token._value = expr::ops::NEQ(n1, n2);
 	return token;
 }
 
@@ -201,7 +304,7 @@ expr::TOKEN expr::TOKEN::NNE(const double n1, const double n2) {
 
 	expr::TOKEN token;
 	token._type = expr::T_NUMBER;
-	token._value = n1 != n2 ? (double)1 : (double)0;
+	token._value = expr::ops::NNE(n1, n2);
 	return token;
 }
 
@@ -209,7 +312,7 @@ expr::TOKEN expr::TOKEN::NLT(const double n1, const double n2) {
 
 	expr::TOKEN token;
 	token._type = expr::T_NUMBER;
-	token._value = n1 < n2 ? (double)1 : (double)0;
+	token._value = expr::ops::NLT(n1, n2);
 	return token;
 }
 
@@ -217,7 +320,7 @@ expr::TOKEN expr::TOKEN::NLE(const double n1, const double n2) {
 
 	expr::TOKEN token;
 	token._type = expr::T_NUMBER;
-	token._value = n1 <= n2 ? (double)1 : (double)0;
+	token._value = expr::ops::NLE(n1, n2);
 	return token;
 }
 
@@ -225,7 +328,7 @@ expr::TOKEN expr::TOKEN::NGT(const double n1, const double n2) {
 
 	expr::TOKEN token;
 	token._type = expr::T_NUMBER;
-	token._value = n1 > n2 ? (double)1 : (double)0;
+	token._value = expr::ops::NGT(n1, n2);
 	return token;
 }
 
@@ -233,7 +336,7 @@ expr::TOKEN expr::TOKEN::NGE(const double n1, const double n2) {
 
 	expr::TOKEN token;
 	token._type = expr::T_NUMBER;
-	token._value = n1 >= n2 ? (double)1 : (double)0;
+	token._value = expr::ops::NGE(n1, n2);
 	return token;
 }
 
@@ -241,7 +344,7 @@ expr::TOKEN expr::TOKEN::SEQ(const std::string& s1, const std::string& s2) {
 
 	expr::TOKEN token;
 	token._type = expr::T_NUMBER;
-	token._value = s1.compare(s2) == 0 ? (double)1 : (double)0;
+	token._value = expr::ops::SEQ(s1, s2);
 	return token;
 }
 
@@ -249,15 +352,15 @@ expr::TOKEN expr::TOKEN::SNE(const std::string& s1, const std::string& s2) {
 
 	expr::TOKEN token;
 	token._type = expr::T_NUMBER;
-	token._value = s1.compare(s2) != 0 ? (double)1 : (double)0;
+	token._value = expr::ops::SNE(s1, s2);
 	return token;
 }
 
 expr::TOKEN expr::TOKEN::SLT(const std::string& s1, const std::string& s2) {
 
 	expr::TOKEN token;
-	token._type = T_NUMBER;
-	token._value = s1.compare(s2) < 0 ? (double)1 : (double)0;
+	token._type = expr::T_NUMBER;
+	token._value = expr::ops::SLT(s1, s2);
 	return token;
 }
 
@@ -265,15 +368,15 @@ expr::TOKEN expr::TOKEN::SLE(const std::string& s1, const std::string& s2) {
 
 	expr::TOKEN token;
 	token._type = expr::T_NUMBER;
-	token._value = s1.compare(s2) <= 0 ? (double)1 : (double)0;
+	token._value = expr::ops::SLE(s1, s2);
 	return token;
 }
 
 expr::TOKEN expr::TOKEN::SGT(const std::string& s1, const std::string& s2) {
 
 	expr::TOKEN token;
-	token._type = T_NUMBER;
-	token._value = s1.compare(s2) > 0 ? (double)1 : (double)0;
+	token._type = expr::T_NUMBER;
+	token._value = expr::ops::SGT(s1, s2);
 	return token;
 }
 
@@ -281,7 +384,7 @@ expr::TOKEN expr::TOKEN::SGE(const std::string& s1, const std::string& s2) {
 
 	expr::TOKEN token;
 	token._type = expr::T_NUMBER;
-	token._value = s1.compare(s2) >= 0 ? (double)1 : (double)0;
+	token._value = expr::ops::SGE(s1, s2);
 	return token;
 }
 
@@ -308,3 +411,11 @@ expr::TOKEN expr::TOKEN::STRING(const std::string& s) {
 	token._value = s;
 	return token;
 }
+
+expr::TOKEN expr::TOKEN::STRING(std::string&& s) {
+
+	expr::TOKEN token;
+	token._type = expr::T_STRING;
+	token._value = std::move(s);
+	return token;
+}
@@ -0,0 +1,145 @@
+#include "expr/tree.hpp"
+
+// children of token in order they are stored, missing
+// parts of conditional are stored as undefined nodes
+static std::vector<const expr::TOKEN*> children(const expr::TOKEN& token) {
+
+	std::vector<const expr::TOKEN*> v;
+
+	switch ( token.type()) {
+		case expr::T_OPERATOR:
+		case expr::T_FUNCTION:
+			for ( const expr::TOKEN& arg : token.args())
+				v.push_back(&arg);
+			break;
+		case expr::T_SUB:
+			for ( const expr::TOKEN& child : token.child())
+				v.push_back(&child);
+			break;
+		case expr::T_CONDITIONAL:
+			v.push_back(token.child().empty() ? nullptr : &token.child().front());
+			v.push_back(token.cond1().empty() ? nullptr : &token.cond1().front());
+			v.push_back(token.cond2().empty() ? nullptr : &token.cond2().front());
+			break;
+		default:
+			break;
+	}
+
+	return v;
+}
+
+expr::tree::tree() {
+}
+
+expr::tree::tree(const expr::TOKEN& root) {
+
+	if ( root == expr::T_UNDEF )
+		return;
+
+	this -> _nodes.reserve(this -> count(root));
+	this -> _nodes.emplace_back();
+	this -> store(0, root);
+}
+
+const size_t expr::tree::count(const expr::TOKEN& token) const {
+
+	size_t nodes = 1;
+
+	for ( const expr::TOKEN *child : children(token))
+		nodes += child == nullptr ? 1 : this -> count(*child);
+
+	return nodes;
+}
+
+void expr::tree::store(const uint32_t index, const expr::TOKEN& token) {
+
+	expr::NODE node;
+	node.type = token._type;
+	node.op = token._op;
+
+	if ( token == expr::T_NUMBER )
+		node.number = token.raw_double();
+	else if ( token == expr::T_STRING ) {
+		node.text = (expr::SYMBOL)this -> _strings.size();
+		this -> _strings.push_back(std::get<std::string>(token._value));
+	} else if ( token == expr::T_VARIABLE || token == expr::T_FUNCTION )
+		node.text = expr::symbols::global().intern(token._name);
+
+	std::vector<const expr::TOKEN*> v = children(token);
+
+	node.count = (uint16_t)v.size();
+	node.first = (uint32_t)this -> _nodes.size();
+	this -> _nodes.resize(this -> _nodes.size() + v.size());
+	this -> _nodes[index] = node;
+
+	for ( size_t i = 0; i < v.size(); i++ )
+		if ( v[i] != nullptr )
+			this -> store(node.first + i, *v[i]);
+}
+
+expr::TOKEN expr::tree::token(const uint32_t index) const {
+
+	const expr::NODE& node = this -> _nodes[index];
+	expr::TOKEN t;
+
+	t._type = (expr::TYPE)node.type;
+	t._op = (expr::OP)node.op;
+
+	if ( t._type == expr::T_NUMBER )
+		t._value = node.number;
+	else if ( t._type == expr::T_STRING )
+		t._value = std::string(this -> text(node));
+	else if ( t._type == expr::T_VARIABLE || t._type == expr::T_FUNCTION )
+		t._name = std::string(this -> text(node));
+
+	switch ( t._type ) {
+		case expr::T_OPERATOR:
+		case expr::T_FUNCTION:
+			t._args.reserve(node.count);
+			for ( uint32_t i = 0; i < node.count; i++ )
+				t._args.push_back(this -> token(node.first + i));
+			break;
+		case expr::T_SUB:
+			for ( uint32_t i = 0; i < node.count; i++ )
+				t._child.push_back(this -> token(node.first + i));
+			break;
+		case expr::T_CONDITIONAL:
+			if ( this -> _nodes[node.first].type != expr::T_UNDEF )
+				t._child.push_back(this -> token(node.first));
+			if ( this -> _nodes[node.first + 1].type != expr::T_UNDEF )
+				t._cond1.push_back(this -> token(node.first + 1));
+			if ( this -> _nodes[node.first + 2].type != expr::T_UNDEF )
+				t._cond2.push_back(this -> token(node.first + 2));
+			break;
+		default:
+			break;
+	}
+
+	return t;
+}
+
+const std::vector<expr::NODE>& expr::tree::nodes() const {
+	return this -> _nodes;
+}
+
+const std::string_view expr::tree::text(const expr::NODE& node) const {
+	return node.type == expr::T_STRING ? this -> _strings[node.text] : expr::symbols::global().string(node.text);
+}
+
+const bool expr::tree::empty() const {
+	return this -> _nodes.empty();
+}
+
+const size_t expr::tree::size() const {
+
+	size_t bytes = this -> _nodes.capacity() * sizeof(expr::NODE) + this -> _strings.capacity() * sizeof(std::string);
+
+	for ( const std::string& s : this -> _strings )
+		bytes += s.size();
+
+	return bytes;
+}
+
+expr::TOKEN expr::tree::root() const {
+	return this -> _nodes.empty() ? expr::TOKEN() : this -> token(0);
+}
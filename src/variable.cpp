@@ -1,3 +1,5 @@
+#include <cmath>
+#include <cstring>
 #include "common.hpp"
 #include "logger.hpp"
 #include "expr/variable.hpp"
@@ -189,6 +191,19 @@ const std::string expr::VARIABLE::to_string() const {
 	return operator std::string();
 }
 
+const bool expr::VARIABLE::same(const expr::VARIABLE& other) const {
+
+	if ( this -> index() != other.index())
+		return false;
+	else if ( const double *d = std::get_if<double>(this))
+		return std::isnan(*d) ? std::isnan(std::get<double>(other)) :
+			std::memcmp(d, &std::get<double>(other), sizeof(double)) == 0;
+	else if ( const std::string *s = std::get_if<std::string>(this))
+		return *s == std::get<std::string>(other);
+
+	return true;
+}
+
 const bool expr::VARIABLE::is_null() const {
 	return this -> type() == V_NULLPTR;
 }
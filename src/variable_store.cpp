@@ -0,0 +1,145 @@
+#include <utility>
+#include "common.hpp"
+#include "expr/variable_store.hpp"
+
+expr::variable_store::variable_store() {
+}
+
+expr::variable_store::variable_store(const expr::VARIABLEMAP& m) {
+
+	for ( const auto& [name, value] : m )
+		this -> set(name, value);
+}
+
+const size_t expr::variable_store::slot(const expr::SYMBOL id) {
+
+	if ( auto it = this -> _slots_of.find(id); it != this -> _slots_of.end())
+		return it -> second;
+
+	this -> _slots_of[id] = this -> _names.size();
+	this -> _names.push_back(expr::symbols::global().string(id));
+	this -> _values.emplace_back();
+	this -> _versions.push_back(0);
+	this -> _set.push_back(false);
+	return this -> _names.size() - 1;
+}
+
+const size_t expr::variable_store::slot(const std::string& name) {
+
+	return this -> slot(expr::symbols::global().identifier(name));
+}
+
+const size_t expr::variable_store::find(const expr::SYMBOL id) const {
+
+	auto it = this -> _slots_of.find(id);
+	return it == this -> _slots_of.end() ? expr::variable_store::NONE : it -> second;
+}
+
+const size_t expr::variable_store::find(const std::string& name) const {
+
+	expr::SYMBOL id = expr::symbols::global().find(common::to_lower(std::as_const(name)));
+	return id == expr::symbols::NONE ? expr::variable_store::NONE : this -> find(id);
+}
+
+const bool expr::variable_store::set(const size_t slot, const expr::VARIABLE& value) {
+
+	if ( this -> _set[slot] && this -> _values[slot].same(value))
+		return false;
+
+	this -> _values[slot] = value;
+	this -> _set[slot] = true;
+	this -> _versions[slot] = ++this -> _version;
+	return true;
+}
+
+const bool expr::variable_store::set(const std::string& name, const expr::VARIABLE& value) {
+
+	return this -> set(this -> slot(name), value);
+}
+
+const bool expr::variable_store::erase(const size_t slot) {
+
+	if ( slot >= this -> _set.size() || !this -> _set[slot] )
+		return false;
+
+	this -> _values[slot].emplace<std::nullptr_t>(nullptr);
+	this -> _set[slot] = false;
+	this -> _versions[slot] = ++this -> _version;
+	return true;
+}
+
+const bool expr::variable_store::erase(const std::string& name) {
+
+	return this -> erase(this -> find(name));
+}
+
+const bool expr::variable_store::contains(const std::string& name) const {
+
+	return this -> is_set(this -> find(name));
+}
+
+const bool expr::variable_store::is_set(const size_t slot) const {
+
+	return slot < this -> _set.size() && this -> _set[slot];
+}
+
+const expr::VARIABLE& expr::variable_store::get(const size_t slot) const {
+
+	return this -> _values[slot];
+}
+
+const expr::VARIABLE& expr::variable_store::operator [](const std::string& name) const {
+
+	static const expr::VARIABLE null;
+	size_t slot = this -> find(name);
+
+	return slot == expr::variable_store::NONE ? null : this -> _values[slot];
+}
+
+const std::string& expr::variable_store::name(const size_t slot) const {
+
+	return this -> _names[slot];
+}
+
+const size_t expr::variable_store::size() const {
+
+	return this -> _names.size();
+}
+
+const uint64_t expr::variable_store::version() const {
+
+	return this -> _version;
+}
+
+const uint64_t expr::variable_store::version(const size_t slot) const {
+
+	return this -> _versions[slot];
+}
+
+const bool expr::variable_store::changed_since(const uint64_t version) const {
+
+	return this -> _version > version;
+}
+
+const size_t expr::variable_store::changed_since(const uint64_t version, std::vector<size_t>& slots) const {
+
+	size_t count = 0;
+
+	if ( this -> _version <= version )
+		return 0;
+
+	for ( size_t slot = 0; slot < this -> _versions.size(); slot++ )
+		if ( this -> _versions[slot] > version ) {
+			slots.push_back(slot);
+			count++;
+		}
+
+	return count;
+}
+
+void expr::variable_store::copy_to(expr::VARIABLEMAP& m) const {
+
+	for ( size_t slot = 0; slot < this -> _names.size(); slot++ )
+		if ( this -> _set[slot] )
+			m[this -> _names[slot]] = this -> _values[slot];
+}
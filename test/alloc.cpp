@@ -0,0 +1,123 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cstdlib>
+#include <new>
+
+#include "logger.hpp"
+#include "expr/expression.hpp"
+#include "expr/bound_expression.hpp"
+#include "expr/variable_store.hpp"
+
+// evaluation must not allocate once context of thread and caches are
+// warm. Every operator new of process is counted
+
+static size_t allocations = 0;
+
+void* operator new(size_t size) {
+
+	allocations++;
+
+	if ( void *p = std::malloc(size == 0 ? 1 : size); p != nullptr )
+		return p;
+
+	throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept {
+	std::free(p);
+}
+
+void operator delete(void *p, size_t) noexcept {
+	std::free(p);
+}
+
+static const size_t passes = 1000;
+
+static expr::expression *inner = nullptr;
+static expr::VARIABLEMAP *variables = nullptr;
+
+// user function that evaluates another expression on same thread
+static expr::VARIABLE nested(const expr::FUNCTION_ARGS& args) {
+
+	return inner -> evaluate(nullptr, variables).to_double() + ( args.empty() ? 0 : args[0].to_double());
+}
+
+static const std::vector<std::string> sources = {
+	"cpu_load * 100",
+	"mem_used / mem_total * 100 + 0.5",
+	"(temp - 32) * 5 / 9",
+	"temp > 70 && fan eq 'auto' ? 1 : 0",
+	"'CPU ' . round(cpu_load * 100) . '%'",
+	"cpu_load > 0.8 ? 3 : cpu_load > 0.5 ? 2 : 1",
+	"sqrt(temp) + min(cpu_load, 4) + round(temp)",
+	"((((((((temp + 1) * 2) + 3) * 4) + 5) * 6) + 7) * 8) + max(1, max(2, max(3, max(4, temp))))",
+	"nested(cpu_load + 1) + nested(temp)"
+};
+
+// allocations of passes evaluations, after one evaluation to warm up
+template <typename F> static size_t count(F f) {
+
+	f();
+
+	size_t before = allocations;
+
+	for ( size_t i = 0; i < passes; i++ )
+		f();
+
+	return allocations - before;
+}
+
+int main() {
+
+	logger::loglevel(logger::error);
+
+	expr::FUNCTIONMAP functions = { { "nested", nested } };
+	expr::VARIABLEMAP map = {
+		{ "cpu_load", 0.5 }, { "temp", 71.0 }, { "mem_used", 1234.0 },
+		{ "mem_total", 4096.0 }, { "fan", std::string("auto") }
+	};
+	expr::variable_store store(map);
+	expr::expression e_inner("temp * 2");
+	size_t checks = 0;
+	int failed = 0;
+
+	inner = &e_inner;
+	variables = &map;
+
+	auto check = [&](const std::string& what, const std::string& source, const size_t n) {
+
+		checks++;
+
+		if ( n != 0 ) {
+			std::cout << "FAIL: " << source << " with " << what << ": " << n << " allocations in " <<
+				passes << " evaluations" << std::endl;
+			failed = 1;
+		}
+	};
+
+	for ( const std::string& source : sources ) {
+
+		expr::expression e(source);
+
+		check("variable map", source, count([&]() { e.evaluate(&functions, &map); }));
+		check("variable store", source, count([&]() { e.evaluate(&functions, store); }));
+	}
+
+	expr::SCHEMA schema = { "cpu_load", "temp", "fan" };
+	std::vector<expr::VARIABLE> slots = { 0.5, 71.0, std::string("auto") };
+	expr::context ctx;
+
+	for ( const char *source : { "cpu_load * temp + sqrt(temp)", "temp > 70 && fan eq 'auto' ? 1 : 0" }) {
+
+		expr::bound_expression b(expr::expression(source), schema, &functions);
+
+		check("slots", source, count([&]() { b.evaluate(slots); }));
+		check("slots and own context", source, count([&]() { b.evaluate(ctx, slots); }));
+	}
+
+	if ( failed == 0 )
+		std::cout << "alloc: " << checks << " checks passed" << std::endl;
+
+	return failed;
+}
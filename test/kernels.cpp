@@ -0,0 +1,166 @@
+#include <iostream>
+#include <vector>
+#include <random>
+#include <cstring>
+#include <cmath>
+#include <cerrno>
+#include <cfloat>
+
+#include "logger.hpp"
+#include "expr/ops.hpp"
+#include "expr/kernels.hpp"
+
+// kernels of every instruction set that cpu supports must give results
+// that are bit-identical to expr::ops, applied row by row. NaN results
+// only need to be NaN, as sign and payload of NaN from two NaN operands
+// change with optimization level
+
+static const std::vector<expr::OP> binary_ops = {
+	expr::OP_ADD, expr::OP_SUB, expr::OP_MUL, expr::OP_DIV, expr::OP_MOD, expr::OP_POW,
+	expr::OP_OR, expr::OP_OR2, expr::OP_AND, expr::OP_AND2, expr::OP_NEQ, expr::OP_NNE,
+	expr::OP_NLT, expr::OP_NLE, expr::OP_NGT, expr::OP_NGE
+};
+
+static const std::vector<expr::OP> unary_ops = { expr::OP_SUB, expr::OP_NOT, expr::OP_NNOT };
+
+static const std::vector<expr::kernels::ISA> isas = {
+	expr::kernels::ISA_GENERIC, expr::kernels::ISA_SSE2,
+	expr::kernels::ISA_AVX2, expr::kernels::ISA_AVX512
+};
+
+static double scalar(const expr::OP op, const double a, const double b) {
+
+	switch ( op ) {
+		case expr::OP_ADD: return expr::ops::ADD(a, b);
+		case expr::OP_SUB: return expr::ops::SUB(a, b);
+		case expr::OP_MUL: return expr::ops::MUL(a, b);
+		case expr::OP_DIV: return expr::ops::DIV(a, b);
+		case expr::OP_MOD: return expr::ops::MOD(a, b);
+		case expr::OP_POW: return expr::ops::POW(a, b);
+		case expr::OP_OR2:
+		case expr::OP_OR: return expr::ops::OR(a, b);
+		case expr::OP_AND2:
+		case expr::OP_AND: return expr::ops::AND(a, b);
+		case expr::OP_NEQ: return expr::ops::NEQ(a, b);
+		case expr::OP_NNE: return expr::ops::NNE(a, b);
+		case expr::OP_NLT: return expr::ops::NLT(a, b);
+		case expr::OP_NLE: return expr::ops::NLE(a, b);
+		case expr::OP_NGT: return expr::ops::NGT(a, b);
+		default: return expr::ops::NGE(a, b);
+	}
+}
+
+static double scalar(const expr::OP op, const double a) {
+
+	return op == expr::OP_SUB ? expr::ops::SGN(a) :
+		( op == expr::OP_NOT ? expr::ops::NOT(a) : expr::ops::NNOT(a));
+}
+
+// small exact numbers, numbers of wide range or specials and random bits
+static double generate(std::mt19937_64& rng, const int mode) {
+
+	static const double specials[] = {
+		0.0, -0.0, 1.0, -1.0, NAN, -NAN, INFINITY, -INFINITY, DBL_MIN, DBL_MAX,
+		1e-310, -1e-310, 3.0, 0.1, 1e300, 1e-300
+	};
+
+	if ( mode == 0 )
+		return (double)((int64_t)( rng() % 2001 ) - 1000 ) / 8.0 + 0.5;
+	else if ( mode == 1 && rng() % 4 != 0 )
+		return std::ldexp((double)( rng() % 100000 ) / 1000.0 - 50, (int)( rng() % 60 ) - 30);
+	else if ( rng() % 2 != 0 )
+		return specials[rng() % 16];
+
+	uint64_t bits = rng();
+	double d;
+	std::memcpy(&d, &bits, sizeof(double));
+	return d;
+}
+
+static bool identical(const std::vector<double>& r, const std::vector<double>& ref, const std::string& what) {
+
+	for ( size_t i = 0; i < r.size(); i++ ) {
+
+		if ( std::memcmp(&r[i], &ref[i], sizeof(double)) == 0 || ( std::isnan(r[i]) && std::isnan(ref[i])))
+			continue;
+
+		std::cout << "FAIL: " << what << ", row " << i << " of " << r.size() << ": " <<
+			r[i] << ", expected " << ref[i] << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+int main() {
+
+	logger::loglevel(logger::error);
+
+	std::mt19937_64 rng(3);
+	expr::kernels::ISA selected = expr::kernels::isa();
+	size_t checks = 0;
+	bool passed = true;
+
+	for ( size_t n : { 0, 1, 3, 7, 255, 256, 257, 1000, 4099 }) {
+
+		for ( int mode = 0; mode < 3; mode++ ) {
+
+			std::vector<double> a(n), b(n), ref(n), r(n);
+
+			for ( size_t i = 0; i < n; i++ ) {
+				a[i] = generate(rng, mode);
+				b[i] = generate(rng, mode);
+			}
+
+			for ( expr::OP op : binary_ops ) {
+
+				// division tests errno, which stays set once set
+				errno = 0;
+				for ( size_t i = 0; i < n; i++ )
+					ref[i] = scalar(op, a[i], b[i]);
+
+				for ( expr::kernels::ISA isa : isas ) {
+
+					if ( !expr::kernels::select(isa))
+						continue;
+
+					std::string what = describe(op) + " on " + describe(isa);
+
+					errno = 0;
+					expr::kernels::binary(op, a, b, r);
+					passed &= identical(r, ref, what);
+
+					errno = 0;
+					r = a;
+					expr::kernels::binary(op, r, b, r);
+					passed &= identical(r, ref, what + " in place");
+					checks += 2;
+				}
+			}
+
+			for ( expr::OP op : unary_ops ) {
+
+				for ( size_t i = 0; i < n; i++ )
+					ref[i] = scalar(op, a[i]);
+
+				for ( expr::kernels::ISA isa : isas ) {
+
+					if ( !expr::kernels::select(isa))
+						continue;
+
+					expr::kernels::unary(op, a, r);
+					passed &= identical(r, ref, "unary " + describe(op) + " on " + describe(isa));
+					checks++;
+				}
+			}
+		}
+	}
+
+	expr::kernels::select(selected);
+
+	if ( !passed )
+		return 1;
+
+	std::cout << "kernels: " << checks << " checks passed, selected isa is " << describe(selected) << std::endl;
+	return 0;
+}